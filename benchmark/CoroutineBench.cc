@@ -0,0 +1,169 @@
+#include <spdlog/spdlog.h>
+#include <array>
+#include <future>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Coroutine.h"
+#include "LocalCluster.h"
+#include "MulProtocol.h"
+#include "SharingProtocol.h"
+#include "Timer.h"
+#include "Type.h"
+#include "Util.h"
+
+// Throughput of many independent MulOn instances, with all five parties in one process:
+// today's thread-per-task model (one blocking thread per instance and party, as in
+// tests/MulNode.cc) against coroutines interleaved on a Scheduler with a fixed worker count.
+//   CoroutineBench [instances] [muls_per_instance] [worker counts...]
+
+struct Instance {
+    std::unique_ptr<Node> node;
+    TaskContext ctx;
+};
+
+using Parties = std::array<std::vector<Instance>, 6>;
+
+const std::vector<uint8_t> kMulOnMsg = [] {
+    std::vector<uint8_t> msg{ProtocolType::MUL_ON};
+    msg.insert(msg.end(), 12, 0);
+    writeUint32(msg, 1, 1);
+    writeUint32(msg, 5, 2);
+    writeUint32(msg, 9, 3);
+    return msg;
+}();
+
+// Shares the two inputs and runs MulOff, blocking, one thread per instance and party.
+void Setup(LocalCluster& cluster, Parties& parties, int instances) {
+    std::vector<std::future<void>> setups;
+    for (int id = 1; id <= 5; id++) {
+        for (int i = 0; i < instances; i++) {
+            Instance& instance = parties[id][i];
+            instance.node = std::make_unique<Node>(id, 3);
+            instance.ctx = TaskContext{i + 1, 1};
+            setups.push_back(std::async(std::launch::async, [&, id] {
+                Node& node = *instance.node;
+                NetworkNode& network_node = cluster.GetNetworkNode(id);
+                if (id == 1) {
+                    node.SetValues(1, 12345 + instance.ctx.task_id);
+                    node.SetValues(2, 67890);
+                }
+                std::vector<uint8_t> share_msg = {
+                    ProtocolType::SHARE_BETA_OFF, 1, 2, 3, 4, 5, 0, 0, 0, 0};
+                for (uint32_t key = 1; key <= 3; key++) {
+                    writeUint32(share_msg, 6, key);
+                    SharingBetaOfflineProtocol::Handle(share_msg, node);
+                }
+                share_msg[0] = ProtocolType::SHARE_BETA;
+                for (uint32_t key = 1; key <= 2; key++) {
+                    writeUint32(share_msg, 6, key);
+                    SharingBetaProtocol::Handle(share_msg, node, network_node, instance.ctx);
+                    instance.ctx.operation_id++;
+                }
+                std::vector<uint8_t> mul_msg = kMulOnMsg;
+                mul_msg[0] = ProtocolType::MUL_OFF;
+                MulOffProtocol().Handle(mul_msg, node, network_node, instance.ctx);
+                instance.ctx.operation_id += 20;
+            }));
+        }
+    }
+    for (auto& setup : setups) {
+        setup.get();
+    }
+}
+
+// beta_z is public, so every party must end up with the same one per instance.
+int CountMismatches(const Parties& parties, int instances) {
+    int mismatches = 0;
+    for (int i = 0; i < instances; i++) {
+        const uint64_t beta = parties[1][i].node->BetaShares(3).Beta();
+        for (int id = 2; id <= 5; id++) {
+            mismatches += parties[id][i].node->BetaShares(3).Beta() != beta;
+        }
+    }
+    return mismatches;
+}
+
+void Report(const std::string& model, int threads, long long wall_us, int instances, int muls,
+            int mismatches) {
+    const double ops = static_cast<double>(instances) * muls;
+    std::cout << model << " (" << threads << " threads): " << ops * 1e6 / wall_us
+              << " MulOn/s, " << wall_us / 1000 << " ms, " << mismatches << " mismatches"
+              << std::endl;
+}
+
+void RunThreads(LocalCluster& cluster, Parties& parties, int instances, int muls) {
+    Timer timer;
+    timer.start();
+    std::vector<std::future<void>> tasks;
+    for (int id = 1; id <= 5; id++) {
+        for (Instance& instance : parties[id]) {
+            tasks.push_back(std::async(std::launch::async, [&, id] {
+                MulOnProtocol protocol;
+                for (int m = 0; m < muls; m++) {
+                    protocol.Handle(kMulOnMsg, *instance.node, cluster.GetNetworkNode(id),
+                                    instance.ctx);
+                    instance.ctx.operation_id += 5;
+                }
+            }));
+        }
+    }
+    for (auto& task : tasks) {
+        task.get();
+    }
+    timer.stop();
+    Report("thread per task", 5 * instances, timer.elapsedMicroseconds(), instances, muls,
+           CountMismatches(parties, instances));
+}
+
+ProtocolTask<> MulLoop(Instance& instance, NetworkNode& network_node, int muls) {
+    for (int m = 0; m < muls; m++) {
+        co_await MulOnProtocol::HandleAsync(kMulOnMsg, *instance.node, network_node,
+                                            instance.ctx);
+        instance.ctx.operation_id += 5;
+    }
+}
+
+void RunCoroutines(LocalCluster& cluster, Parties& parties, int instances, int muls,
+                   int workers) {
+    Scheduler scheduler(workers);
+    Timer timer;
+    timer.start();
+    for (int id = 1; id <= 5; id++) {
+        for (Instance& instance : parties[id]) {
+            scheduler.Spawn(MulLoop(instance, cluster.GetNetworkNode(id), muls));
+        }
+    }
+    scheduler.WaitIdle();
+    timer.stop();
+    Report("coroutines", workers, timer.elapsedMicroseconds(), instances, muls,
+           CountMismatches(parties, instances));
+}
+
+int main(int argc, char* argv[]) {
+    const int instances = argc >= 2 ? std::stoi(argv[1]) : 200;
+    const int muls = argc >= 3 ? std::stoi(argv[2]) : 50;
+    std::vector<int> worker_counts;
+    for (int i = 3; i < argc; i++) {
+        worker_counts.push_back(std::stoi(argv[i]));
+    }
+    if (worker_counts.empty()) {
+        worker_counts = {1, 2, 4, 8};
+    }
+    spdlog::set_level(spdlog::level::warn);
+
+    LocalCluster cluster(1);
+    Parties parties;
+    for (int id = 1; id <= 5; id++) {
+        parties[id].resize(instances);
+    }
+    Setup(cluster, parties, instances);
+
+    RunThreads(cluster, parties, instances, muls);
+    for (const int workers : worker_counts) {
+        RunCoroutines(cluster, parties, instances, muls, workers);
+    }
+    return 0;
+}
@@ -2,9 +2,11 @@
 #include <ctpl_stl.h>
 #include <spdlog/spdlog.h>
 #include <sys/ipc.h>
+#include <sys/resource.h>
 #include <sys/shm.h>
 #include <sys/types.h>
 #include <sys/wait.h>
+#include <algorithm>
 #include <future>
 #include <iostream>
 #include <memory>
@@ -12,10 +14,12 @@
 #include "A2BProtocol.h"
 #include "B2AProtocol.h"
 #include "DotProductProtocol.h"
+#include "KeySetupProtocol.h"
 #include "MulProtocol.h"
 #include "NetworkNode.h"
 #include "PCNode.h"
 #include "RecProtocol.h"
+#include "ShareStore.h"
 #include "SharedMemory.h"
 #include "SharingProtocol.h"
 #include "Timer.h"
@@ -23,12 +27,31 @@
 #include "Type.h"
 #include "Util.h"
 
+// One layer's weight shares per entry, read by every per-neuron Node without being copied.
+using ModelLayers = std::vector<std::shared_ptr<const ShareStore<CipherData>>>;
+
+// Task id of the parent's key-setup phase; InitModel uses task 0.
+constexpr int kKeySetupTaskId = 1;
+
+// Offline-randomness nonce of one Node. All processes share the subset keys, so the nonce names
+// the session fully: the inference process (process_id + 1; 0 is the parent's InitModel), the
+// layer (0 outside the layers) and the task id, which repeats across processes and layers.
+uint64_t SessionNonce(int process_slot, int layer, int task_id) {
+    return static_cast<uint64_t>(process_slot) << 48 | static_cast<uint64_t>(layer) << 32 |
+           static_cast<uint32_t>(task_id);
+}
+
 std::pair<uint32_t, CipherData> SinglePointInference(
     int task_id, int operation_id, NetworkNode& network_node, int output,
-    const std::unordered_map<uint32_t, CipherData>& model_beta_shares_map,
-    const std::unordered_map<uint32_t, CipherData>& input_data, const FcnnLayerConfig& config) {
+    const std::shared_ptr<const ShareStore<CipherData>>& layer_shares,
+    const FcnnLayerConfig& config, const std::shared_ptr<const SubsetKeys>& keys,
+    uint64_t session_nonce) {
     TaskContext ctx = {task_id, operation_id};
+    TaskSession session(network_node, task_id);
     Node node(network_node.ID(), 999);
+    node.SetSubsetKeys(keys);
+    node.SetSession(session_nonce);
+    node.SetSharedBetaShares(layer_shares);
     // node.SkipOfflinePhase();
 
     uint32_t work_space = 100;
@@ -38,13 +61,6 @@ std::pair<uint32_t, CipherData> SinglePointInference(
     uint32_t output_start_idx = config.output_start_idx;
     uint32_t weight_start_idx = config.weight_start_idx;
 
-    for (const auto& entry : model_beta_shares_map) {
-        node.SetBetaShares(entry.first, entry.second);
-    }
-    for (const auto& entry : input_data) {
-        node.SetBetaShares(entry.first, entry.second);
-    }
-
     // dot product
     std::vector<uint8_t> dot_msg{ProtocolType::DOT_PRODUCT_OFF};
     dot_msg.insert(dot_msg.end(), 16, 0);
@@ -135,16 +151,22 @@ std::pair<uint32_t, CipherData> SinglePointInference(
     mul_on_proto->Handle(mul_msg, node, network_node, ctx);
     ctx.operation_id += 5;
 
+    if (!network_node.VerifyJmp(ctx.task_id, ctx.operation_id)) {
+        throw std::runtime_error("JMP verification failed for output " + std::to_string(output));
+    }
+
     return {output_start_idx + output, node.BetaShares(3)};
 }
 
-uint64_t FcnnInferenceTask(
-    int task_id, int operation_id, NetworkNode& network_node,
-    const std::unordered_map<uint8_t, std::unordered_map<uint32_t, CipherData>>&
-        model_beta_shares_map,
-    const std::vector<uint64_t>& input_data, ctpl::thread_pool& pool) {
+uint64_t FcnnInferenceTask(int process_id, int task_id, int operation_id,
+                           NetworkNode& network_node, const ModelLayers& model_layers,
+                           const std::shared_ptr<const SubsetKeys>& keys,
+                           const std::vector<uint64_t>& input_data, ctpl::thread_pool& pool) {
     TaskContext ctx = {task_id, operation_id};
+    TaskSession session(network_node, task_id);
     Node node(network_node.ID(), 0);
+    node.SetSubsetKeys(keys);
+    node.SetSession(SessionNonce(process_id + 1, 0, task_id));
 
     uint32_t input_space = 1000;
     if (node.ID() == 1) {
@@ -170,22 +192,22 @@ uint64_t FcnnInferenceTask(
         const FcnnLayerConfig& config = FcnnLayerConfigs[layer - 1];
         uint32_t output_size = config.output_size;
         uint32_t output_start_idx = config.output_start_idx;
-        auto input_beta_shares_map = node.GetBetaSharesMapCopy();
-        node.ResetBetaShares();
+        Timer layer_timer;
+        layer_timer.start();
 
-        auto current_layer_weight_iter = model_beta_shares_map.find(layer);
-        if (current_layer_weight_iter == model_beta_shares_map.end()) {
-            throw std::runtime_error("Layer weight not found in model_beta_shares_map");
-        }
-        const auto& current_layer_weight = current_layer_weight_iter->second;
+        // This layer's inputs over its weights, shared by all of the layer's neurons.
+        auto layer_shares = std::make_shared<ShareStore<CipherData>>(node.GetBetaSharesMap());
+        layer_shares->SetBase(model_layers.at(layer - 1));
+        node.ResetBetaShares();
+        const std::shared_ptr<const ShareStore<CipherData>> shared_layer = layer_shares;
 
         std::vector<std::future<std::pair<uint32_t, CipherData>>> tasks;
         for (int output_idx = 0; output_idx < output_size; output_idx++) {
             tasks.push_back(pool.push(
                 [&](int /*thread_id*/, int inference_id, int output_pos) {
-                    return SinglePointInference(inference_id, 1, network_node, output_pos,
-                                                current_layer_weight, input_beta_shares_map,
-                                                config);
+                    return SinglePointInference(
+                        inference_id, 1, network_node, output_pos, shared_layer, config, keys,
+                        SessionNonce(process_id + 1, layer, inference_id));
                 },
                 task_id + output_idx + 1, output_idx));
         }
@@ -198,6 +220,9 @@ uint64_t FcnnInferenceTask(
                 node.SetBetaShares(result.first - output_start_idx, result.second);
             }
         }
+        layer_timer.stop();
+        std::cout << "[Node " << node.ID() << "] Task " << task_id << " layer " << layer << ": "
+                  << layer_timer.elapsedMicroseconds() << " us\n";
     }
 
     std::vector<uint64_t> res{};
@@ -216,10 +241,13 @@ uint64_t FcnnInferenceTask(
 }
 
 std::shared_ptr<std::unordered_map<uint8_t, std::unordered_map<uint32_t, CipherData>>> InitModel(
-    int task_id, int operation_id, NetworkNode& network_node) {
+    int task_id, int operation_id, NetworkNode& network_node,
+    const std::shared_ptr<const SubsetKeys>& keys) {
     TaskContext ctx = {task_id, operation_id};
     FCNNWeights model = load_model_weights("./benchmark/model_weights.bin");
     Node node(network_node.ID(), 0);
+    node.SetSubsetKeys(keys);
+    node.SetSession(SessionNonce(0, 0, task_id));
 
     auto result_map =
         std::make_shared<std::unordered_map<uint8_t, std::unordered_map<uint32_t, CipherData>>>();
@@ -302,7 +330,26 @@ std::shared_ptr<std::unordered_map<uint8_t, std::unordered_map<uint32_t, CipherD
     return result_map;
 }
 
-void RunChildProcess(int node_id, int process_id, int shm_id_model, int shm_id_test) {
+// One line per peer: how often its copy came last in a majority receive, by how long it
+// trailed the second copy.
+void PrintStragglers(int node_id, const NetworkStats& stats) {
+    for (int peer_id = 1; peer_id <= 5; peer_id++) {
+        const auto& buckets = stats.stragglers[peer_id];
+        if (std::all_of(buckets.begin(), buckets.end(), [](uint64_t n) { return n == 0; })) {
+            continue;
+        }
+        std::cout << "[Node " << node_id << "] Straggler " << peer_id << ":";
+        for (int bucket = 0; bucket < kStragglerBuckets; bucket++) {
+            if (buckets[bucket] > 0) {
+                std::cout << " <" << (1ULL << bucket) << "us=" << buckets[bucket];
+            }
+        }
+        std::cout << "\n";
+    }
+}
+
+void RunChildProcess(int node_id, int process_id, int shm_id_model, int shm_id_test,
+                     const NetworkOptions& options, const std::shared_ptr<const SubsetKeys>& keys) {
     ctpl::thread_pool pool(std::thread::hardware_concurrency());
 
     void* model_shm_ptr = shmat(shm_id_model, nullptr, 0);
@@ -319,6 +366,16 @@ void RunChildProcess(int node_id, int process_id, int shm_id_model, int shm_id_t
     SharedMemoryHelper::deserializeMap(model_shm_ptr, model_beta_shares_map);
     SharedMemoryHelper::deserializeVector(test_shm_ptr, test_images);
 
+    ModelLayers model_layers;
+    for (uint8_t layer = 1; layer <= FcnnLayerConfigs.size(); layer++) {
+        auto layer_shares = std::make_shared<ShareStore<CipherData>>();
+        for (const auto& [id, share] : model_beta_shares_map.at(layer)) {
+            (*layer_shares)[id] = share;
+        }
+        model_layers.push_back(std::move(layer_shares));
+    }
+    model_beta_shares_map.clear();
+
     const int base_port = 5556 + 5 * process_id;
     std::unordered_map<int, std::string> node_addresses;
     for (int i = 0; i < 5; i++) {
@@ -326,18 +383,29 @@ void RunChildProcess(int node_id, int process_id, int shm_id_model, int shm_id_t
     }
 
     int io_threads = 1;
-    NetworkNode network_node(node_id, io_threads, node_addresses);
+    NetworkNode network_node(node_id, io_threads, node_addresses, options);
 
     std::thread receiver(&NetworkNode::ReceiveMessages, &network_node);
     std::thread sender(&NetworkNode::SendMessages, &network_node);
+    network_node.WaitForPeers();
 
-    uint64_t result = FcnnInferenceTask(process_id, 1, network_node, model_beta_shares_map,
-                                        test_images[process_id], pool);
+    uint64_t result =
+        FcnnInferenceTask(process_id, process_id, 1, network_node, model_layers, keys,
+                          test_images[process_id], pool);
 
-    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    network_node.Drain();
     network_node.Stop();
     receiver.join();
     sender.join();
+    const NetworkStats stats = network_node.Stats();
+    std::cout << "[Node " << node_id << "] Process " << process_id << ": " << stats.bytes_sent
+              << " bytes sent, " << stats.jmp_copies_digested << " JMP copies digested, "
+              << stats.early_accepts << " early accepts\n";
+    PrintStragglers(node_id, stats);
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+    std::cout << "[Node " << node_id << "] Process " << process_id << ": peak RSS "
+              << usage.ru_maxrss / 1024 << " MiB\n";
 
     shmdt(model_shm_ptr);
     shmdt(test_shm_ptr);
@@ -345,8 +413,9 @@ void RunChildProcess(int node_id, int process_id, int shm_id_model, int shm_id_t
 }
 
 int main(int argc, char* argv[]) {
-    if (argc != 3) {
-        std::cerr << "Usage: ./FcnnNode <node_id> <num_processes>\n";
+    if (argc < 3 || argc > 7) {
+        std::cerr << "Usage: ./FcnnNode <node_id> <num_processes> [link_profile] [--jmp-digests] "
+                     "[--early-accept] [--key-setup]\n";
         return 1;
     }
 
@@ -362,13 +431,42 @@ int main(int argc, char* argv[]) {
         return 1;
     }
 
+    NetworkOptions options;
+    bool key_setup = false;
+    for (int i = 3; i < argc; i++) {
+        if (std::string(argv[i]) == "--jmp-digests") {
+            options.jmp_digests = true;
+        } else if (std::string(argv[i]) == "--early-accept") {
+            options.early_accept = true;
+        } else if (std::string(argv[i]) == "--key-setup") {
+            key_setup = true;
+        } else {
+            options.link_profile = argv[i];
+        }
+    }
+
     int io_threads = 1;
-    NetworkNode network_node(node_id, io_threads);
+    NetworkNode network_node(node_id, io_threads, default_node_addresses, options);
 
     std::thread receiver(&NetworkNode::ReceiveMessages, &network_node);
     std::thread sender(&NetworkNode::SendMessages, &network_node);
+    network_node.WaitForPeers();
+
+    // Without --key-setup every party derives all subset keys from the same default key, which
+    // keeps no randomness private. The forked processes inherit the agreed keys.
+    std::shared_ptr<const SubsetKeys> keys = SubsetKeys::Default();
+    if (key_setup) {
+        Timer key_timer;
+        key_timer.start();
+        Node key_node(network_node.ID(), 0);
+        keys = KeySetupProtocol::Handle(key_node, network_node, TaskContext{kKeySetupTaskId, 1});
+        network_node.CloseTask(kKeySetupTaskId);
+        key_timer.stop();
+        std::cout << "[Node " << node_id << "] Key setup: " << key_timer.elapsedMicroseconds()
+                  << " us\n";
+    }
 
-    auto model_ptr = InitModel(0, 1, network_node);
+    auto model_ptr = InitModel(0, 1, network_node, keys);
     const auto& model_beta_shares_map = *model_ptr;
 
     std::vector<std::vector<uint64_t>> test_images =
@@ -404,7 +502,7 @@ int main(int argc, char* argv[]) {
     for (int i = 0; i < num_processes; i++) {
         pid_t pid = fork();
         if (pid == 0) {
-            RunChildProcess(node_id, i, shm_id_model, shm_id_test_data);
+            RunChildProcess(node_id, i, shm_id_model, shm_id_test_data, options, keys);
         } else if (pid > 0) {
             child_pids.push_back(pid);
         } else {
@@ -424,11 +522,17 @@ int main(int argc, char* argv[]) {
     shmctl(shm_id_model, IPC_RMID, nullptr);
     shmctl(shm_id_test_data, IPC_RMID, nullptr);
 
-    std::this_thread::sleep_for(std::chrono::seconds(5));
+    network_node.Drain();
     network_node.Stop();
 
     receiver.join();
     sender.join();
+    const NetworkStats stats = network_node.Stats();
+    std::cout << "[Node " << network_node.ID() << "] Receive loop: " << stats.spin_iterations
+              << " spin iterations, " << stats.blocking_wakeups << " blocking wakeups\n";
+    std::cout << "[Node " << network_node.ID() << "] Send queue: high-water mark "
+              << stats.send_queue_high_water_mark << ", " << stats.send_queue_parks
+              << " producer parks\n";
     std::cout << "[Node " << network_node.ID() << "] Stopped.\n";
 
     return 0;
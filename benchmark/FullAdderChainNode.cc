@@ -0,0 +1,88 @@
+#include <spdlog/spdlog.h>
+#include <iostream>
+#include <string>
+
+#include "A2BProtocol.h"
+#include "NetworkNode.h"
+#include "PCNode.h"
+#include "SharingProtocol.h"
+#include "Timer.h"
+#include "Type.h"
+#include "Util.h"
+
+// Latency of one sequential A2B_ON call: a 64-bit SingleBitFullAdder ripple-carry chain. Each
+// bit runs two bit multiplications (MUL_OFF + MUL_ON each), i.e. four dependent communication
+// rounds. Run once with auto-flush and once with "noflush" to see how much of each round was
+// spent waiting out WAIT_TIME.
+
+void FullAdderChainTask(int task_id, int operation_id, NetworkNode& network_node, int chains) {
+    TaskContext ctx = {task_id, operation_id};
+    uint32_t share_count = 360;
+    Node node(network_node.ID(), share_count);
+
+    uint8_t bit_key = 1;
+    uint8_t result_start_id = 10;
+    uint32_t input_id = 1;
+    if (node.ID() == 1) {
+        node.SetValues(input_id, 50893722547205813);
+    }
+
+    std::vector<uint8_t> share_msg = {ProtocolType::SHARE_BETA_OFF, 1, 2, 3, 4, 5, 0, 0, 0, 0};
+    writeUint32(share_msg, 6, input_id);
+    SharingBetaOfflineProtocol::Handle(share_msg, node);
+
+    std::vector<uint8_t> a2b_msg = {ProtocolType::A2B_OFF, 0, 0, result_start_id, bit_key};
+    a2b_msg[1] = static_cast<uint8_t>(static_cast<uint16_t>(input_id) >> 8);
+    a2b_msg[2] = static_cast<uint8_t>(static_cast<uint16_t>(input_id) & 0xFF);
+    A2BOffProtocol::Handle(a2b_msg, node, network_node, ctx);
+
+    share_msg[0] = ProtocolType::SHARE_BETA;
+    SharingBetaProtocol::Handle(share_msg, node, network_node, ctx);
+    ctx.operation_id++;
+
+    a2b_msg[0] = ProtocolType::A2B_ON;
+    Timer timer;
+    timer.start();
+    for (int i = 0; i < chains; i++) {
+        A2BOnProtocol::Handle(a2b_msg, node, network_node, ctx);
+    }
+    timer.stop();
+    std::cout << "64-bit chain latency: " << timer.elapsedMicroseconds() / chains << " us ("
+              << chains << " chains, " << timer.elapsedMicroseconds() / (chains * 64 * 4)
+              << " us per round)" << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 2 || argc > 4) {
+        std::cerr << "Usage: ./FullAdderChainNode <node_id> [flush|noflush] [link_profile]\n";
+        return 1;
+    }
+    int node_id = std::stoi(argv[1]);
+    if (node_id < 1 || node_id > 5) {
+        std::cerr << "Invalid node_id. Choose between 1-5.\n";
+        return 1;
+    }
+
+    NetworkOptions options;
+    options.auto_flush = !(argc >= 3 && std::string(argv[2]) == "noflush");
+    if (argc == 4) {
+        options.link_profile = argv[3];
+    }
+
+    int io_threads = 1;
+    NetworkNode network_node(node_id, io_threads, default_node_addresses, options);
+
+    std::thread receiver(&NetworkNode::ReceiveMessages, &network_node);
+    std::thread sender(&NetworkNode::SendMessages, &network_node);
+    network_node.WaitForPeers();
+
+    FullAdderChainTask(0, 1, network_node, 10);
+
+    network_node.Drain();
+    network_node.Stop();
+
+    receiver.join();
+    sender.join();
+    std::cout << "[Node " << network_node.ID() << "] Stopped.\n";
+    return 0;
+}
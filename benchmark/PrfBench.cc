@@ -0,0 +1,76 @@
+#include <openssl/aes.h>
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "Prf.h"
+#include "Timer.h"
+
+// PRF throughput in blocks/s: the former Node::PRFEval (two heap-allocated blocks and one
+// AES_encrypt per call) against Prf::Eval and Prf::EvalBatch at a few batch sizes. Every run
+// must produce the same outputs as the former implementation.
+//   PrfBench [blocks]
+
+const std::vector<uint8_t> kKey(Prf::kKeySize, 1);
+
+uint64_t LegacyEval(const AES_KEY& key, uint64_t input) {
+    std::vector<uint8_t> input_block(AES_BLOCK_SIZE, 0);
+    *reinterpret_cast<uint64_t*>(input_block.data()) = input;
+
+    std::vector<uint8_t> output_block(AES_BLOCK_SIZE);
+    AES_encrypt(input_block.data(), output_block.data(), &key);
+    return *reinterpret_cast<uint64_t*>(output_block.data());
+}
+
+size_t CountMismatches(const std::vector<uint64_t>& out, const std::vector<uint64_t>& expected) {
+    size_t mismatches = 0;
+    for (size_t i = 0; i < out.size(); ++i) {
+        mismatches += out[i] != expected[i];
+    }
+    return mismatches;
+}
+
+void Report(const std::string& name, size_t blocks, long long elapsed_us, size_t mismatches) {
+    std::cout << name << ": " << static_cast<uint64_t>(blocks * 1e6 / elapsed_us) << " blocks/s, "
+              << mismatches << " mismatches" << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    const size_t blocks = argc >= 2 ? std::stoul(argv[1]) : 1 << 22;
+    AES_KEY legacy_key;
+    AES_set_encrypt_key(kKey.data(), 128, &legacy_key);
+    Prf prf;
+    prf.SetKey(kKey.data());
+    std::cout << "AES-NI: " << (Prf::HasAesNi() ? "yes" : "no") << std::endl;
+
+    std::vector<uint64_t> expected(blocks);
+    Timer timer;
+    timer.start();
+    for (size_t i = 0; i < blocks; ++i) {
+        expected[i] = LegacyEval(legacy_key, i);
+    }
+    timer.stop();
+    Report("legacy PRFEval", blocks, timer.elapsedMicroseconds(), 0);
+
+    std::vector<uint64_t> out(blocks);
+    timer.start();
+    for (size_t i = 0; i < blocks; ++i) {
+        out[i] = prf.Eval(i);
+    }
+    timer.stop();
+    Report("Eval", blocks, timer.elapsedMicroseconds(), CountMismatches(out, expected));
+
+    for (const size_t batch : {5, 8, 100, 4096}) {
+        std::fill(out.begin(), out.end(), 0);
+        timer.start();
+        for (size_t i = 0; i < blocks; i += batch) {
+            prf.EvalBatch(i, std::min(batch, blocks - i), out.data() + i);
+        }
+        timer.stop();
+        Report("EvalBatch(" + std::to_string(batch) + ")", blocks, timer.elapsedMicroseconds(),
+               CountMismatches(out, expected));
+    }
+    return 0;
+}
@@ -0,0 +1,276 @@
+#include <spdlog/spdlog.h>
+#include <future>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "A2BProtocol.h"
+#include "Coroutine.h"
+#include "DotProductProtocol.h"
+#include "LocalCluster.h"
+#include "MulProtocol.h"
+#include "RecProtocol.h"
+#include "SharingProtocol.h"
+#include "TruncationProtocol.h"
+#include "Type.h"
+#include "Util.h"
+
+// Per-protocol cost of the online phases, with all five parties in one process on an in-memory
+// transport. Each benchmark runs the same offline setup as the matching tests/*Node program and
+// then times `repetitions` online calls. TrunOn is timed both blocking and as a coroutine on a
+// Scheduler, and the two results are checked against each other. Options after the repetition
+// count:
+//   jmp-digests   JMP rounds send one copy plus digests; online steps that JMP end with a
+//                 VerifyJmp() checkpoint
+//   early-accept  majority receives complete on two matching copies
+//   dispatch=<n>  inbound batches go to n dispatcher threads sharded by task id
+//   key-setup     each cluster runs the key-setup phase before its offline setup and reports
+//                 its cost, instead of drawing randomness from the shared default keys
+//   <file>        link profile, e.g. benchmark/straggler_profile.txt
+
+void ShareInputs(Node& node, NetworkNode& network_node, TaskContext& ctx, uint32_t first,
+                 uint32_t last, uint32_t offline_last) {
+    std::vector<uint8_t> share_msg = {ProtocolType::SHARE_BETA_OFF, 1, 2, 3, 4, 5, 0, 0, 0, 0};
+    for (uint32_t i = first; i <= offline_last; i++) {
+        writeUint32(share_msg, 6, i);
+        SharingBetaOfflineProtocol::Handle(share_msg, node);
+    }
+    share_msg[0] = ProtocolType::SHARE_BETA;
+    for (uint32_t i = first; i <= last; i++) {
+        writeUint32(share_msg, 6, i);
+        SharingBetaProtocol::Handle(share_msg, node, network_node, ctx);
+        ctx.operation_id++;
+    }
+}
+
+// Runs the key-setup phase on a fresh cluster if requested.
+void SetupKeys(LocalCluster& cluster, bool key_setup) {
+    if (key_setup) {
+        LocalCluster::Print(cluster.SetupKeys());
+    }
+}
+
+// Closes a digest-mode JMP window; a no-op without options.jmp_digests.
+void VerifyJmp(NetworkNode& network_node, TaskContext& ctx) {
+    if (!network_node.VerifyJmp(ctx.task_id, ctx.operation_id)) {
+        throw std::runtime_error("JMP verification failed");
+    }
+    ctx.operation_id += 16;
+}
+
+// Signals `done` once `task` has finished, so a party thread can wait for a spawned task. The
+// promise is shared because the waiter may return while set_value() is still running.
+ProtocolTask<> Signal(ProtocolTask<> task, std::shared_ptr<std::promise<void>> done) {
+    try {
+        co_await task;
+        done->set_value();
+    } catch (...) {
+        done->set_exception(std::current_exception());
+    }
+}
+
+ClusterReport BenchMul(int repetitions, const NetworkOptions& options, bool key_setup) {
+    LocalCluster cluster(3, options);
+    SetupKeys(cluster, key_setup);
+    std::vector<uint8_t> mul_msg{ProtocolType::MUL_OFF};
+    mul_msg.insert(mul_msg.end(), 12, 0);
+    writeUint32(mul_msg, 1, 1);
+    writeUint32(mul_msg, 5, 2);
+    writeUint32(mul_msg, 9, 3);
+
+    cluster.Run("setup", [&](Node& node, NetworkNode& network_node, TaskContext& ctx) {
+        if (node.ID() == 1) {
+            node.SetValues(1, 12345);
+            node.SetValues(2, 67890);
+        }
+        ShareInputs(node, network_node, ctx, 1, 2, 3);
+        MulOffProtocol().Handle(mul_msg, node, network_node, ctx);
+        ctx.operation_id += 20;
+    });
+
+    mul_msg[0] = ProtocolType::MUL_ON;
+    return cluster.Run(
+        "MulOn",
+        [&](Node& node, NetworkNode& network_node, TaskContext& ctx) {
+            MulOnProtocol().Handle(mul_msg, node, network_node, ctx);
+            ctx.operation_id += 5;
+            VerifyJmp(network_node, ctx);
+        },
+        repetitions);
+}
+
+ClusterReport BenchDotProduct(int repetitions, const NetworkOptions& options, bool key_setup) {
+    const uint32_t dimension = 5;
+    const uint32_t x_start_idx = 1;
+    const uint32_t y_start_idx = x_start_idx + dimension;
+    const uint32_t z_idx = y_start_idx + dimension;
+    LocalCluster cluster(z_idx, options);
+    SetupKeys(cluster, key_setup);
+
+    std::vector<uint8_t> dot_msg{ProtocolType::DOT_PRODUCT_OFF};
+    dot_msg.insert(dot_msg.end(), 16, 0);
+    writeUint32(dot_msg, 1, dimension);
+    writeUint32(dot_msg, 5, x_start_idx);
+    writeUint32(dot_msg, 9, y_start_idx);
+    writeUint32(dot_msg, 13, z_idx);
+
+    cluster.Run("setup", [&](Node& node, NetworkNode& network_node, TaskContext& ctx) {
+        if (node.ID() == 1) {
+            for (uint32_t i = 0; i < dimension; i++) {
+                node.SetValues(x_start_idx + i, 1000 + i);
+                node.SetValues(y_start_idx + i, 2000 + i);
+            }
+        }
+        ShareInputs(node, network_node, ctx, x_start_idx, z_idx - 1, z_idx);
+        DotProductOffProtocol::Handle(dot_msg, node, network_node, ctx);
+        ctx.operation_id += 20;
+    });
+
+    dot_msg[0] = ProtocolType::DOT_PRODUCT_ON;
+    return cluster.Run(
+        "DotProductOn",
+        [&](Node& node, NetworkNode& network_node, TaskContext& ctx) {
+            DotProductOnProtocol::Handle(dot_msg, node, network_node, ctx);
+            ctx.operation_id += 5;
+        },
+        repetitions);
+}
+
+std::vector<ClusterReport> BenchTrun(int repetitions, const NetworkOptions& options,
+                                     bool key_setup) {
+    LocalCluster cluster(500, options);
+    SetupKeys(cluster, key_setup);
+    const uint8_t r_key = 1;
+    const uint32_t occupancy_start_id = 10;
+    const uint32_t input_id = 1;
+    const uint8_t result_id = 2;
+
+    cluster.Run("setup", [&](Node& node, NetworkNode& network_node, TaskContext& ctx) {
+        if (node.ID() == 1) {
+            node.SetValues(input_id, 50893722547205813);
+        }
+        std::vector<uint8_t> share_msg = {ProtocolType::SHARE_BETA_OFF, 1, 2, 3, 4, 5, 0, 0, 0, 0};
+        writeUint32(share_msg, 6, input_id);
+        SharingBetaOfflineProtocol::Handle(share_msg, node);
+
+        std::vector<uint8_t> trun_off_msg = {ProtocolType::TRUN_OFF, r_key, 0, 0, 0, 0};
+        writeUint32(trun_off_msg, 2, occupancy_start_id);
+        TrunOffProtocol::Handle(trun_off_msg, node, network_node, ctx);
+
+        share_msg[0] = ProtocolType::SHARE_BETA;
+        SharingBetaProtocol::Handle(share_msg, node, network_node, ctx);
+        ctx.operation_id++;
+    });
+
+    const std::vector<uint8_t> trun_on_msg = {ProtocolType::TRUN_ON,
+                                              static_cast<uint8_t>(input_id), r_key, result_id};
+    std::vector<ClusterReport> reports;
+    reports.push_back(cluster.Run(
+        "TrunOn",
+        [&](Node& node, NetworkNode& network_node, TaskContext& ctx) {
+            TrunOnProtocol::Handle(trun_on_msg, node, network_node, ctx);
+            VerifyJmp(network_node, ctx);
+        },
+        repetitions));
+
+    // Opens the truncated value to party 5.
+    const std::vector<uint8_t> rec_msg = {ProtocolType::REC, 2, 3, 4, 5, result_id};
+    const auto reconstruct = [&] {
+        cluster.Run("reconstruct", [&](Node& node, NetworkNode& network_node, TaskContext& ctx) {
+            ReconstructionProtocol::Handle(rec_msg, node, network_node, ctx);
+            ctx.operation_id++;
+            VerifyJmp(network_node, ctx);
+        });
+        return cluster.GetNode(5).Values(result_id);
+    };
+    const uint64_t expected = reconstruct();
+
+    // ctx is the party's context in the cluster, which outlives the awaited task.
+    Scheduler scheduler(2);
+    reports.push_back(cluster.Run(
+        "TrunOnAsync",
+        [&](Node& node, NetworkNode& network_node, TaskContext& ctx) {
+            auto done = std::make_shared<std::promise<void>>();
+            std::future<void> finished = done->get_future();
+            scheduler.Spawn(
+                Signal(TrunOnProtocol::HandleAsync(trun_on_msg, node, network_node, ctx), done));
+            finished.get();
+            VerifyJmp(network_node, ctx);
+        },
+        repetitions));
+    const uint64_t result = reconstruct();
+    if (result != expected) {
+        throw std::runtime_error("TrunOnAsync opened " + std::to_string(result) +
+                                 ", blocking TrunOn " + std::to_string(expected));
+    }
+    return reports;
+}
+
+ClusterReport BenchA2B(int repetitions, const NetworkOptions& options, bool key_setup) {
+    LocalCluster cluster(360, options);
+    SetupKeys(cluster, key_setup);
+    const uint8_t bit_key = 1;
+    const uint8_t result_start_id = 10;
+    const uint32_t input_id = 1;
+
+    std::vector<uint8_t> a2b_msg = {ProtocolType::A2B_OFF, 0, 0, result_start_id, bit_key};
+    a2b_msg[1] = static_cast<uint8_t>(static_cast<uint16_t>(input_id) >> 8);
+    a2b_msg[2] = static_cast<uint8_t>(static_cast<uint16_t>(input_id) & 0xFF);
+
+    cluster.Run("setup", [&](Node& node, NetworkNode& network_node, TaskContext& ctx) {
+        if (node.ID() == 1) {
+            node.SetValues(input_id, 50893722547205813);
+        }
+        std::vector<uint8_t> share_msg = {ProtocolType::SHARE_BETA_OFF, 1, 2, 3, 4, 5, 0, 0, 0, 0};
+        writeUint32(share_msg, 6, input_id);
+        SharingBetaOfflineProtocol::Handle(share_msg, node);
+        A2BOffProtocol::Handle(a2b_msg, node, network_node, ctx);
+
+        share_msg[0] = ProtocolType::SHARE_BETA;
+        SharingBetaProtocol::Handle(share_msg, node, network_node, ctx);
+        ctx.operation_id++;
+    });
+
+    a2b_msg[0] = ProtocolType::A2B_ON;
+    return cluster.Run(
+        "A2BOn",
+        [&](Node& node, NetworkNode& network_node, TaskContext& ctx) {
+            A2BOnProtocol::Handle(a2b_msg, node, network_node, ctx);
+            VerifyJmp(network_node, ctx);
+        },
+        repetitions);
+}
+
+int main(int argc, char* argv[]) {
+    int repetitions = 200;
+    NetworkOptions options;
+    bool key_setup = false;
+    if (argc >= 2) {
+        repetitions = std::stoi(argv[1]);
+    }
+    for (int i = 2; i < argc; i++) {
+        const std::string option = argv[i];
+        if (option == "jmp-digests") {
+            options.jmp_digests = true;
+        } else if (option == "early-accept") {
+            options.early_accept = true;
+        } else if (option == "key-setup") {
+            key_setup = true;
+        } else if (option.rfind("dispatch=", 0) == 0) {
+            options.dispatch_threads = std::stoi(option.substr(9));
+        } else {
+            options.link_profile = option;
+        }
+    }
+    spdlog::set_level(spdlog::level::warn);
+
+    LocalCluster::Print(BenchMul(repetitions, options, key_setup));
+    LocalCluster::Print(BenchDotProduct(repetitions, options, key_setup));
+    for (const ClusterReport& report : BenchTrun(repetitions, options, key_setup)) {
+        LocalCluster::Print(report);
+    }
+    LocalCluster::Print(BenchA2B(std::max(1, repetitions / 20), options, key_setup));
+    return 0;
+}
@@ -0,0 +1,178 @@
+#include <array>
+#include <atomic>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <zmq.hpp>
+
+#include "BufferPool.h"
+#include "NetworkNode.h"
+#include "Timer.h"
+#include "WireFormat.h"
+
+// Heap allocations per batch on the send/receive path, legacy string batches vs pooled
+// zero-copy frames. Each batch carries BATCH_SIZE values spread over four peers and goes
+// through an inproc PAIR socket, so the numbers include building, sending and parsing.
+// Only operator new is counted; ZeroMQ's own malloc calls are not visible here.
+
+static std::atomic<uint64_t> g_allocations{0};
+
+void* operator new(size_t size) {
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* ptr = std::malloc(size == 0 ? 1 : size)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept {
+    std::free(ptr);
+}
+
+constexpr size_t kLegacyMsgSize = 100;
+
+struct BenchResult {
+    uint64_t allocations = 0;
+    uint64_t checksum = 0;
+    long long elapsed_us = 0;
+};
+
+uint64_t Value(size_t i) {
+    return i * 0x9E3779B97F4A7C15ULL;
+}
+
+BenchResult RunLegacy(zmq::socket_t& out, zmq::socket_t& in, size_t batches) {
+    BenchResult result;
+    const uint64_t before = g_allocations.load();
+    Timer timer;
+    timer.start();
+    for (size_t b = 0; b < batches; ++b) {
+        std::vector<std::array<char, kLegacyMsgSize>> batch;
+        batch.reserve(BATCH_SIZE);
+        for (size_t i = 0; i < BATCH_SIZE; ++i) {
+            std::array<char, kLegacyMsgSize> msg;
+            snprintf(msg.data(), msg.size(), "%d-%d-%d-%" PRIu64, static_cast<int>(i % 4) + 2,
+                     static_cast<int>(b % 1000), static_cast<int>(i / 4), Value(i));
+            batch.push_back(msg);
+        }
+
+        std::unordered_map<int, std::string> batched_messages;
+        for (const auto& message : batch) {
+            std::string_view msg_view(message.data());
+            size_t pos1 = msg_view.find('-');
+            int peer_id = std::stoi(std::string(msg_view.substr(0, pos1)));
+            std::string updated_message = std::to_string(1) + std::string(msg_view.substr(pos1));
+            batched_messages[peer_id] += updated_message + "|";
+        }
+
+        for (auto& [peer_id, full_message] : batched_messages) {
+            out.send(zmq::message_t(full_message), zmq::send_flags::none);
+            zmq::message_t message;
+            (void)in.recv(message, zmq::recv_flags::none);
+            std::string msg_str = message.to_string();
+            size_t pos = 0;
+            while (pos < msg_str.size()) {
+                size_t next_pos = msg_str.find('|', pos);
+                std::string single_msg = msg_str.substr(pos, next_pos - pos);
+                pos = (next_pos == std::string::npos) ? msg_str.size() : next_pos + 1;
+
+                int task_id, operation_id, sender_id;
+                uint64_t value;
+                if (sscanf(single_msg.c_str(), "%d-%d-%d-%" PRIu64, &sender_id, &task_id,
+                           &operation_id, &value) == 4) {
+                    result.checksum += value;
+                }
+            }
+        }
+    }
+    timer.stop();
+    result.elapsed_us = timer.elapsedMicroseconds();
+    result.allocations = g_allocations.load() - before;
+    return result;
+}
+
+BenchResult RunPooled(zmq::socket_t& out, zmq::socket_t& in, size_t batches) {
+    BenchResult result;
+    BufferPool pool;
+    std::array<FrameWriter, 6> writers;
+    zmq::message_t message;
+
+    const uint64_t before = g_allocations.load();
+    Timer timer;
+    timer.start();
+    for (size_t b = 0; b < batches; ++b) {
+        for (auto& writer : writers) {
+            writer.Reset(1);
+        }
+        for (size_t i = 0; i < BATCH_SIZE; ++i) {
+            writers[i % 4 + 2].Append(static_cast<int>(b % 1000), static_cast<int>(i / 4),
+                                      Value(i));
+        }
+
+        for (auto& writer : writers) {
+            if (writer.Empty()) {
+                continue;
+            }
+            PooledBuffer* buffer = pool.Acquire();
+            writer.SwapBuffer(buffer->bytes);
+            out.send(zmq::message_t(buffer->bytes.data(), buffer->bytes.size(),
+                                    &BufferPool::Release, buffer),
+                     zmq::send_flags::none);
+            (void)in.recv(message, zmq::recv_flags::none);
+            FrameReader reader(message.data(), message.size());
+            FrameView frame{};
+            while (reader.Next(frame)) {
+                for (uint32_t i = 0; i < frame.count; ++i) {
+                    result.checksum += frame.Value(i);
+                }
+            }
+        }
+    }
+    timer.stop();
+    result.elapsed_us = timer.elapsedMicroseconds();
+    result.allocations = g_allocations.load() - before;
+    return result;
+}
+
+void Report(const char* name, const BenchResult& result, size_t batches) {
+    std::cout << name << ": " << static_cast<double>(result.allocations) / batches
+              << " allocations/batch, " << result.elapsed_us * 1000 / batches << " ns/batch"
+              << " (checksum " << result.checksum << ")" << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    size_t batches = 200000;
+    if (argc == 2) {
+        batches = std::stoul(argv[1]);
+    }
+
+    zmq::context_t context(1);
+    zmq::socket_t in(context, ZMQ_PAIR);
+    zmq::socket_t out(context, ZMQ_PAIR);
+    in.bind("inproc://send_path_bench");
+    out.connect("inproc://send_path_bench");
+
+    // Warm up both paths so pools and writer buffers reach their steady-state capacity.
+    RunLegacy(out, in, 100);
+    RunPooled(out, in, 100);
+
+    const BenchResult legacy = RunLegacy(out, in, batches);
+    const BenchResult pooled = RunPooled(out, in, batches);
+
+    Report("legacy", legacy, batches);
+    Report("pooled", pooled, batches);
+    if (legacy.checksum != pooled.checksum) {
+        std::cerr << "Checksum mismatch between paths!\n";
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,134 @@
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+#include "CipherData.h"
+#include "ShareStore.h"
+#include "Timer.h"
+#include "Util.h"
+
+// Node's share lookups on the FCNN layer-1 id layout, with the old unordered_map against
+// ShareStore: "load" fills a fresh store with the layer's weights and inputs as
+// SinglePointInference does for every output, "dot" gathers the 784 input and weight shares of
+// each output neuron by id and accumulates the alpha products as DotProductOffProtocol does.
+// The overlay run loads nothing: each pass reads through to one shared copy of the layer, as
+// per-neuron Nodes do with Node::SetSharedBetaShares().
+//   ShareStoreBench [rounds]
+
+using HashMap = std::unordered_map<uint32_t, CipherData>;
+
+const CipherData& Lookup(const HashMap& map, uint32_t id) {
+    return map.find(id)->second;
+}
+
+const CipherData& Lookup(const ShareStore<CipherData>& store, uint32_t id) {
+    return *store.Find(id);
+}
+
+struct Result {
+    long long load_us = 0;
+    long long dot_us = 0;
+    uint64_t checksum = 0;
+};
+
+template <typename Store>
+uint64_t Layer1Dots(const Store& store) {
+    const FcnnLayerConfig& config = FcnnLayerConfigs[0];
+    uint64_t checksum = 0;
+    for (uint32_t output = 0; output < config.output_size; output++) {
+        const uint32_t weight_start = config.weight_start_idx + config.input_size * output;
+        uint64_t sum = 0;
+        for (uint32_t t = 0; t < config.input_size; t++) {
+            const CipherData& x = Lookup(store, config.input_start_idx + t);
+            const CipherData& y = Lookup(store, weight_start + t);
+            for (size_t row = 1; row <= 5; row++) {
+                sum += x.Alpha(row) * y.Alpha(row % 5 + 1);
+            }
+        }
+        checksum += sum;
+    }
+    return checksum;
+}
+
+template <typename Store>
+Result Run(const HashMap& model, int rounds) {
+    Result result;
+    Timer load;
+    Timer dot;
+    for (int round = 0; round < rounds; round++) {
+        load.resume();
+        Store store;
+        for (const auto& [id, share] : model) {
+            store[id] = share;
+        }
+        load.stop();
+
+        dot.resume();
+        result.checksum += Layer1Dots(store);
+        dot.stop();
+    }
+    result.load_us = load.elapsedMicroseconds();
+    result.dot_us = dot.elapsedMicroseconds();
+    return result;
+}
+
+Result RunOverlay(const HashMap& model, int rounds) {
+    auto shared = std::make_shared<ShareStore<CipherData>>();
+    for (const auto& [id, share] : model) {
+        (*shared)[id] = share;
+    }
+    Result result;
+    Timer load;
+    Timer dot;
+    for (int round = 0; round < rounds; round++) {
+        load.resume();
+        ShareStore<CipherData> store;
+        store.SetBase(shared);
+        load.stop();
+
+        dot.resume();
+        result.checksum += Layer1Dots(std::as_const(store));
+        dot.stop();
+    }
+    result.load_us = load.elapsedMicroseconds();
+    result.dot_us = dot.elapsedMicroseconds();
+    return result;
+}
+
+void Report(const std::string& name, const Result& result, int rounds) {
+    std::cout << name << ": load " << result.load_us / rounds << " us, layer-1 lookups "
+              << result.dot_us / rounds << " us per pass (checksum " << result.checksum << ")"
+              << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    const int rounds = argc >= 2 ? std::stoi(argv[1]) : 20;
+    const FcnnLayerConfig& config = FcnnLayerConfigs[0];
+
+    std::mt19937_64 rng(7);
+    HashMap model;
+    auto add = [&](uint32_t id) {
+        CipherData share{};
+        for (size_t i = 1; i <= 5; i++) {
+            share.SetAlpha(rng(), i);
+        }
+        share.SetBeta(rng());
+        model[id] = share;
+    };
+    for (uint32_t t = 0; t < config.input_size; t++) {
+        add(config.input_start_idx + t);
+    }
+    const uint32_t weights = config.input_size * config.output_size + config.output_size;
+    for (uint32_t t = 0; t < weights; t++) {
+        add(config.weight_start_idx + t);
+    }
+
+    Report("unordered_map", Run<HashMap>(model, rounds), rounds);
+    Report("ShareStore   ", Run<ShareStore<CipherData>>(model, rounds), rounds);
+    Report("overlay      ", RunOverlay(model, rounds), rounds);
+    return 0;
+}
@@ -0,0 +1,96 @@
+#include <spdlog/spdlog.h>
+#include <unistd.h>
+#include <atomic>
+#include <fstream>
+#include <future>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "LocalCluster.h"
+
+// Memory soak for task lifecycles: pushes many short tasks through an in-process cluster and
+// prints RSS and the number of live task queues as it goes. With "close" every task is closed
+// when it finishes; with "leak" tasks are left open, which is how the binaries behaved before
+// CloseTask existed. With "async" as third argument the replies are taken with ReceiveAsync()
+// continuations, the last of which closes its task from the dispatch thread.
+
+size_t ResidentKiB() {
+    std::ifstream statm("/proc/self/statm");
+    size_t pages = 0, resident = 0;
+    statm >> pages >> resident;
+    return resident * static_cast<size_t>(sysconf(_SC_PAGESIZE)) / 1024;
+}
+
+int main(int argc, char* argv[]) {
+    int total_tasks = 100000;
+    bool close_tasks = true;
+    bool async_receives = false;
+    if (argc >= 2) {
+        total_tasks = std::stoi(argv[1]);
+    }
+    if (argc >= 3) {
+        close_tasks = std::string(argv[2]) != "leak";
+    }
+    if (argc >= 4) {
+        async_receives = std::string(argv[3]) == "async";
+    }
+    spdlog::set_level(spdlog::level::warn);
+
+    // Each round runs tasks_per_round tasks side by side: every party sends one value per task
+    // to every other party and receives the four replies.
+    const int tasks_per_round = 100;
+    const int report_every = total_tasks / 10;
+
+    LocalCluster cluster(1);
+    int next_report = report_every;
+    for (int first = 0; first < total_tasks; first += tasks_per_round) {
+        cluster.Run("round", [&](Node& node, NetworkNode& network_node, TaskContext& /*ctx*/) {
+            const int last = std::min(total_tasks, first + tasks_per_round);
+            for (int task_id = first; task_id < last; task_id++) {
+                network_node.OpenTask(task_id);
+                for (int peer_id = 1; peer_id <= 5; peer_id++) {
+                    if (peer_id != node.ID()) {
+                        network_node.AddMessage(peer_id, task_id, 1, task_id);
+                    }
+                }
+            }
+            if (async_receives) {
+                std::atomic<int> outstanding{(last - first) * 4};
+                std::promise<void> all_received;
+                std::future<void> received = all_received.get_future();
+                for (int task_id = first; task_id < last; task_id++) {
+                    for (int i = 0; i < 4; i++) {
+                        network_node.ReceiveAsync(task_id, 1, 1, [&, task_id, i](uint64_t) {
+                            // Continuations of one operation run in order, so i == 3 is last.
+                            if (i == 3 && close_tasks) {
+                                network_node.CloseTask(task_id);
+                            }
+                            if (outstanding.fetch_sub(1) == 1) {
+                                all_received.set_value();
+                            }
+                        });
+                    }
+                }
+                received.wait();
+                return;
+            }
+            for (int task_id = first; task_id < last; task_id++) {
+                for (int i = 0; i < 4; i++) {
+                    network_node.Receive(task_id, 1, 1);
+                }
+                if (close_tasks) {
+                    network_node.CloseTask(task_id);
+                }
+            }
+        });
+
+        if (first + tasks_per_round >= next_report) {
+            std::cout << "tasks=" << first + tasks_per_round << " rss_kib=" << ResidentKiB()
+                      << " task_queues=" << cluster.GetNetworkNode(1).Stats().task_queues
+                      << std::endl;
+            next_report += report_every;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,143 @@
+#include <spdlog/spdlog.h>
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "LocalCluster.h"
+#include "MulProtocol.h"
+#include "SharingProtocol.h"
+#include "TruncationProtocol.h"
+#include "Type.h"
+#include "Util.h"
+
+// Online latency under offline load: every party runs `background` TrunOff preprocessing tasks
+// back to back while party 1 times a stream of MulOn calls, once with all traffic in one FIFO
+// (bulk_batches_in_flight = 0) and once with traffic classes.
+//   TrafficClassBench [background] [online_ops] [link_profile]
+
+// Lets every party stop its background loop after the same number of TrunOff calls.
+class StopLine {
+  public:
+    bool Start(int iteration) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (iteration >= limit_) {
+            return false;
+        }
+        furthest_ = std::max(furthest_, iteration);
+        return true;
+    }
+
+    void Stop() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        limit_ = furthest_ + 1;
+    }
+
+  private:
+    std::mutex mutex_;
+    int furthest_ = -1;
+    int limit_ = INT_MAX;
+};
+
+void Background(NetworkNode& network_node, int task_id, StopLine& stop_line, int& completed) {
+    Node node(network_node.ID(), 500);
+    TaskContext ctx{task_id, 1};
+    std::vector<uint8_t> trun_off_msg = {ProtocolType::TRUN_OFF, 1, 0, 0, 0, 0};
+    writeUint32(trun_off_msg, 2, 10);
+    for (int i = 0; stop_line.Start(i); i++) {
+        TrunOffProtocol::Handle(trun_off_msg, node, network_node, ctx);
+        completed = i + 1;
+    }
+}
+
+void Run(const std::string& name, int background, int online_ops, NetworkOptions options) {
+    LocalCluster cluster(3, options);
+    std::vector<uint8_t> mul_msg{ProtocolType::MUL_OFF};
+    mul_msg.insert(mul_msg.end(), 12, 0);
+    writeUint32(mul_msg, 1, 1);
+    writeUint32(mul_msg, 5, 2);
+    writeUint32(mul_msg, 9, 3);
+    cluster.Run("setup", [&](Node& node, NetworkNode& network_node, TaskContext& ctx) {
+        std::vector<uint8_t> share_msg = {ProtocolType::SHARE_BETA_OFF, 1, 2, 3, 4, 5, 0, 0, 0, 0};
+        for (uint32_t key = 1; key <= 3; key++) {
+            writeUint32(share_msg, 6, key);
+            SharingBetaOfflineProtocol::Handle(share_msg, node);
+        }
+        share_msg[0] = ProtocolType::SHARE_BETA;
+        for (uint32_t key = 1; key <= 2; key++) {
+            writeUint32(share_msg, 6, key);
+            SharingBetaProtocol::Handle(share_msg, node, network_node, ctx);
+            ctx.operation_id++;
+        }
+        MulOffProtocol().Handle(mul_msg, node, network_node, ctx);
+        ctx.operation_id += 20;
+    });
+
+    std::vector<StopLine> stop_lines(background);
+    std::vector<int> completed(5 * background);
+    std::vector<std::thread> threads;
+    for (int id = 1; id <= 5; id++) {
+        for (int task = 0; task < background; task++) {
+            threads.emplace_back(Background, std::ref(cluster.GetNetworkNode(id)), task + 1,
+                                 std::ref(stop_lines[task]),
+                                 std::ref(completed[(id - 1) * background + task]));
+        }
+    }
+    // Let the preprocessing get going before measuring.
+    std::this_thread::sleep_for(std::chrono::milliseconds(background > 0 ? 200 : 0));
+
+    std::vector<double> latencies_us;
+    mul_msg[0] = ProtocolType::MUL_ON;
+    const ClusterReport report = cluster.Run(
+        "MulOn",
+        [&](Node& node, NetworkNode& network_node, TaskContext& ctx) {
+            const auto start = std::chrono::steady_clock::now();
+            MulOnProtocol().Handle(mul_msg, node, network_node, ctx);
+            ctx.operation_id += 5;
+            if (node.ID() == 1) {
+                latencies_us.push_back(std::chrono::duration<double, std::micro>(
+                                           std::chrono::steady_clock::now() - start)
+                                           .count());
+            }
+        },
+        online_ops);
+
+    for (auto& stop_line : stop_lines) {
+        stop_line.Stop();
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    std::sort(latencies_us.begin(), latencies_us.end());
+    const NetworkStats stats = cluster.GetNetworkNode(1).Stats();
+    int trun_offs = 0;
+    for (int task = 0; task < background; task++) {
+        trun_offs += completed[task];
+    }
+    std::cout << name << ": MulOn p50 " << latencies_us[latencies_us.size() / 2] << " us, p99 "
+              << latencies_us[latencies_us.size() * 99 / 100] << " us, "
+              << report.wall_us / static_cast<double>(online_ops) << " us/op; " << trun_offs
+              << " TrunOff done, " << stats.bulk_batches_sent << " bulk batches, "
+              << stats.bulk_throttles << " bulk throttles, " << stats.bytes_sent << " bytes sent"
+              << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    const int background = argc >= 2 ? std::stoi(argv[1]) : 4;
+    const int online_ops = argc >= 3 ? std::stoi(argv[2]) : 200;
+    NetworkOptions options;
+    options.link_profile = argc >= 4 ? argv[3] : "benchmark/lan_profile.txt";
+    spdlog::set_level(spdlog::level::warn);
+
+    Run("idle", 0, online_ops, options);
+    NetworkOptions fifo = options;
+    fifo.bulk_batches_in_flight = 0;
+    Run("one FIFO", background, online_ops, fifo);
+    Run("traffic classes", background, online_ops, options);
+    return 0;
+}
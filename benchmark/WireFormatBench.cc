@@ -0,0 +1,146 @@
+#include <array>
+#include <cinttypes>
+#include <cstdio>
+#include <iostream>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "NetworkNode.h"
+#include "Timer.h"
+#include "WireFormat.h"
+
+// Compares the legacy "%d-%d-%d-%llu|" text framing with the binary frame layout on the
+// same stream of messages: one BATCH_SIZE batch per peer, encoded by the sender and decoded
+// by the receiver, as SendMessages/ReceiveMessages do.
+
+constexpr size_t kLegacyMsgSize = 100;
+
+std::vector<OutboundMessage> MakeMessages(size_t count) {
+    std::mt19937_64 rng(42);
+    std::vector<OutboundMessage> messages;
+    messages.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        const int peer_id = static_cast<int>(i % 4) + 2;
+        const int task_id = static_cast<int>(i % 1000);
+        const int operation_id = static_cast<int>(i / 4);
+        messages.push_back(OutboundMessage{peer_id, task_id, operation_id, 1, rng(), nullptr});
+    }
+    return messages;
+}
+
+struct BenchResult {
+    size_t bytes = 0;
+    uint64_t checksum = 0;
+    long long elapsed_us = 0;
+};
+
+BenchResult RunText(const std::vector<OutboundMessage>& messages) {
+    BenchResult result;
+    Timer timer;
+    timer.start();
+    for (size_t begin = 0; begin < messages.size(); begin += BATCH_SIZE) {
+        const size_t end = std::min(messages.size(), begin + BATCH_SIZE);
+
+        std::vector<std::array<char, kLegacyMsgSize>> batch;
+        batch.reserve(BATCH_SIZE);
+        for (size_t i = begin; i < end; ++i) {
+            const auto& m = messages[i];
+            std::array<char, kLegacyMsgSize> msg;
+            snprintf(msg.data(), msg.size(), "%d-%d-%d-%" PRIu64, m.peer_id, m.task_id,
+                     m.operation_id, m.value);
+            batch.push_back(msg);
+        }
+
+        std::unordered_map<int, std::string> batched_messages;
+        for (const auto& message : batch) {
+            std::string_view msg_view(message.data());
+            size_t pos1 = msg_view.find('-');
+            int peer_id = std::stoi(std::string(msg_view.substr(0, pos1)));
+            std::string updated_message = std::to_string(1) + std::string(msg_view.substr(pos1));
+            batched_messages[peer_id] += updated_message + "|";
+        }
+
+        for (auto& [peer_id, msg_str] : batched_messages) {
+            result.bytes += msg_str.size();
+            size_t pos = 0;
+            while (pos < msg_str.size()) {
+                size_t next_pos = msg_str.find('|', pos);
+                std::string single_msg = msg_str.substr(pos, next_pos - pos);
+                pos = (next_pos == std::string::npos) ? msg_str.size() : next_pos + 1;
+
+                int task_id, operation_id, sender_id;
+                uint64_t value;
+                if (sscanf(single_msg.c_str(), "%d-%d-%d-%" PRIu64, &sender_id, &task_id,
+                           &operation_id, &value) == 4) {
+                    result.checksum += value + task_id + operation_id;
+                }
+            }
+        }
+    }
+    timer.stop();
+    result.elapsed_us = timer.elapsedMicroseconds();
+    return result;
+}
+
+BenchResult RunBinary(const std::vector<OutboundMessage>& messages) {
+    BenchResult result;
+    std::array<FrameWriter, 6> writers;
+    Timer timer;
+    timer.start();
+    for (size_t begin = 0; begin < messages.size(); begin += BATCH_SIZE) {
+        const size_t end = std::min(messages.size(), begin + BATCH_SIZE);
+        for (auto& writer : writers) {
+            writer.Reset(1);
+        }
+        for (size_t i = begin; i < end; ++i) {
+            const auto& m = messages[i];
+            writers[m.peer_id].Append(m.task_id, m.operation_id, m.value);
+        }
+
+        for (const auto& writer : writers) {
+            if (writer.Empty()) {
+                continue;
+            }
+            const auto& buffer = writer.Buffer();
+            result.bytes += buffer.size();
+            FrameReader reader(buffer.data(), buffer.size());
+            FrameView frame{};
+            while (reader.Next(frame)) {
+                for (uint32_t i = 0; i < frame.count; ++i) {
+                    result.checksum += frame.Value(i) + frame.task_id + frame.operation_id;
+                }
+            }
+        }
+    }
+    timer.stop();
+    result.elapsed_us = timer.elapsedMicroseconds();
+    return result;
+}
+
+void Report(const char* name, const BenchResult& result, size_t count) {
+    const double seconds = static_cast<double>(result.elapsed_us) / 1e6;
+    std::cout << name << ": " << static_cast<double>(result.bytes) / count << " bytes/op, "
+              << static_cast<uint64_t>(count / seconds) << " msgs/sec"
+              << " (checksum " << result.checksum << ")" << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    size_t count = 2000000;
+    if (argc == 2) {
+        count = std::stoul(argv[1]);
+    }
+
+    const auto messages = MakeMessages(count);
+    const BenchResult text = RunText(messages);
+    const BenchResult binary = RunBinary(messages);
+
+    Report("text  ", text, count);
+    Report("binary", binary, count);
+    if (text.checksum != binary.checksum) {
+        std::cerr << "Checksum mismatch between formats!\n";
+        return 1;
+    }
+    return 0;
+}
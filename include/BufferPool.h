@@ -0,0 +1,97 @@
+#ifndef BUFFERPOOL_H
+#define BUFFERPOOL_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+class BufferPool;
+
+struct PooledBuffer {
+    BufferPool *pool;
+    std::vector<uint8_t> bytes;
+    std::atomic<int> readers{0};  // inbound batches: dispatchers that have yet to finish with it
+};
+
+// Recycles batch buffers: outbound batches, and inbound copies handed to dispatcher threads.
+// A buffer handed to ZeroMQ with Release as its free callback comes back here once the I/O
+// thread is done with it, so steady-state sends allocate nothing. Release may run on any thread.
+class BufferPool {
+  public:
+    explicit BufferPool(size_t max_idle = 64) : max_idle_(max_idle) {}
+
+    BufferPool(const BufferPool &) = delete;
+    BufferPool &operator=(const BufferPool &) = delete;
+
+    ~BufferPool() {
+        for (PooledBuffer *buffer : idle_) {
+            delete buffer;
+        }
+    }
+
+    PooledBuffer *Acquire() {
+        in_use_.fetch_add(1, std::memory_order_relaxed);
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!idle_.empty()) {
+                PooledBuffer *buffer = idle_.back();
+                idle_.pop_back();
+                return buffer;
+            }
+        }
+        allocations_.fetch_add(1, std::memory_order_relaxed);
+        return new PooledBuffer{this, {}};
+    }
+
+    void Put(PooledBuffer *buffer) {
+        buffer->bytes.clear();
+        // Sequentially consistent, like the sender's throttled flag, so that one of the two
+        // sides always sees the other.
+        in_use_.fetch_sub(1);
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (idle_.size() < max_idle_) {
+                idle_.push_back(buffer);
+                buffer = nullptr;
+            }
+        }
+        delete buffer;
+        if (on_return_) {
+            on_return_();
+        }
+    }
+
+    // Called on whichever thread returns a buffer. Set it before the first Acquire().
+    void OnReturn(std::function<void()> callback) {
+        on_return_ = std::move(callback);
+    }
+
+    // Matches zmq::free_fn; `hint` is the PooledBuffer whose bytes were sent.
+    static void Release(void * /*data*/, void *hint) {
+        auto *buffer = static_cast<PooledBuffer *>(hint);
+        buffer->pool->Put(buffer);
+    }
+
+    // Buffers acquired and not yet returned, e.g. batches still queued in the transport.
+    size_t InUse() const {
+        return in_use_.load();
+    }
+
+    // Buffers created because the pool was empty.
+    uint64_t Allocations() const {
+        return allocations_.load(std::memory_order_relaxed);
+    }
+
+  private:
+    const size_t max_idle_;
+    std::mutex mutex_;
+    std::vector<PooledBuffer *> idle_;
+    std::atomic<uint64_t> allocations_{0};
+    std::atomic<size_t> in_use_{0};
+    std::function<void()> on_return_;
+};
+
+#endif  // BUFFERPOOL_H
@@ -0,0 +1,73 @@
+#ifndef CIPHERVECTOR_H
+#define CIPHERVECTOR_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+
+#include "CipherData.h"
+#include "PCNode.h"
+
+// Structure-of-arrays counterpart of std::vector<CipherData>: one column per alpha share and one
+// for beta, each 64-byte aligned, so batch kernels stream a single column at a time instead of
+// striding over six-word records.
+class CipherVector {
+  public:
+    static constexpr size_t kAlignment = 64;
+
+    explicit CipherVector(size_t size = 0);
+
+    CipherVector(CipherVector &&) noexcept = default;
+    CipherVector &operator=(CipherVector &&) noexcept = default;
+
+    // Copies the shares stored under ids start_id .. start_id + count - 1; throws like
+    // Node::BetaShares() if one is missing.
+    static CipherVector Load(const Node &node, uint32_t start_id, size_t count);
+
+    // Writes element i back as the share for id start_id + i.
+    void Store(Node &node, uint32_t start_id) const;
+
+    size_t size() const {
+        return size_;
+    }
+
+    // Column of [[alpha]]_index, 1-based like CipherData::Alpha().
+    uint64_t *Alpha(size_t index) {
+        return data_.get() + (index - 1) * stride_;
+    }
+
+    const uint64_t *Alpha(size_t index) const {
+        return data_.get() + (index - 1) * stride_;
+    }
+
+    uint64_t *Beta() {
+        return data_.get() + 5 * stride_;
+    }
+
+    const uint64_t *Beta() const {
+        return data_.get() + 5 * stride_;
+    }
+
+    CipherData Get(size_t i) const;
+
+    void Set(size_t i, const CipherData &cipher);
+
+  private:
+    struct AlignedDelete {
+        void operator()(uint64_t *data) const {
+            ::operator delete[](data, std::align_val_t{kAlignment});
+        }
+    };
+
+    size_t size_;
+    size_t stride_;  // size_ rounded up to a whole number of cache lines
+    std::unique_ptr<uint64_t[], AlignedDelete> data_;
+};
+
+// One pass over `column` against every column of `vector`: sums[k - 1] = sum(column[i] *
+// vector.Alpha(k)[i]) for k = 1..5 and sums[5] = sum(column[i] * vector.Beta()[i]), mod 2^64.
+// column must hold vector.size() values.
+void ColumnDots(const uint64_t *column, const CipherVector &vector, uint64_t (&sums)[6]);
+
+#endif  // CIPHERVECTOR_H
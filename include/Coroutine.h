@@ -0,0 +1,252 @@
+#ifndef COROUTINE_H
+#define COROUTINE_H
+
+#include <atomic>
+#include <condition_variable>
+#include <coroutine>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "NetworkNode.h"
+
+// Coroutine flavour of the online protocols. A ProtocolTask suspends on network receives
+// instead of blocking its thread; the Scheduler resumes it on one of a fixed set of workers once
+// the value has been dispatched, so many protocol instances share a handful of threads.
+
+namespace coroutine_detail {
+
+// Hands control back to whoever awaited the finished task.
+struct FinalAwaiter {
+    bool await_ready() const noexcept {
+        return false;
+    }
+
+    template <typename Promise>
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> handle) noexcept {
+        const std::coroutine_handle<> continuation = handle.promise().continuation;
+        return continuation ? continuation : std::noop_coroutine();
+    }
+
+    void await_resume() const noexcept {}
+};
+
+struct PromiseBase {
+    std::coroutine_handle<> continuation;
+    std::exception_ptr error;
+
+    std::suspend_always initial_suspend() const noexcept {
+        return {};
+    }
+
+    FinalAwaiter final_suspend() const noexcept {
+        return {};
+    }
+
+    void unhandled_exception() noexcept {
+        error = std::current_exception();
+    }
+};
+
+template <typename T>
+struct Promise : PromiseBase {
+    std::optional<T> value;
+
+    void return_value(T result) {
+        value = std::move(result);
+    }
+
+    T Result() {
+        if (error) {
+            std::rethrow_exception(error);
+        }
+        return std::move(*value);
+    }
+};
+
+template <>
+struct Promise<void> : PromiseBase {
+    void return_void() noexcept {}
+
+    void Result() {
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+};
+
+// Fire-and-forget frame that runs a spawned task to completion and frees itself.
+struct Detached {
+    struct promise_type {
+        Detached get_return_object() noexcept {
+            return {};
+        }
+        std::suspend_never initial_suspend() const noexcept {
+            return {};
+        }
+        std::suspend_never final_suspend() const noexcept {
+            return {};
+        }
+        void return_void() noexcept {}
+        void unhandled_exception() noexcept {
+            std::terminate();
+        }
+    };
+};
+
+}  // namespace coroutine_detail
+
+// Lazily started coroutine: the body runs when the task is co_awaited, and the awaiting
+// coroutine resumes when it finishes. Exceptions propagate to the awaiter. The frame keeps the
+// coroutine's reference parameters (Node, NetworkNode, a TaskContext&) until the task finishes,
+// so their referents must outlive the awaited task, not just the call that created it.
+template <typename T = void>
+class [[nodiscard]] ProtocolTask {
+  public:
+    struct promise_type : coroutine_detail::Promise<T> {
+        ProtocolTask get_return_object() {
+            return ProtocolTask(std::coroutine_handle<promise_type>::from_promise(*this));
+        }
+    };
+
+    ProtocolTask(ProtocolTask &&other) noexcept : handle_(std::exchange(other.handle_, {})) {}
+    ProtocolTask &operator=(ProtocolTask &&other) = delete;
+
+    ~ProtocolTask() {
+        if (handle_) {
+            handle_.destroy();
+        }
+    }
+
+    bool await_ready() const noexcept {
+        return false;
+    }
+
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept {
+        handle_.promise().continuation = awaiting;
+        return handle_;
+    }
+
+    T await_resume() {
+        return handle_.promise().Result();
+    }
+
+  private:
+    explicit ProtocolTask(std::coroutine_handle<promise_type> handle) : handle_(handle) {}
+
+    std::coroutine_handle<promise_type> handle_;
+};
+
+// Fixed pool of worker threads resuming ready coroutines in FIFO order.
+class Scheduler {
+  public:
+    explicit Scheduler(int threads);
+    ~Scheduler();
+
+    Scheduler(const Scheduler &) = delete;
+    Scheduler &operator=(const Scheduler &) = delete;
+
+    // Queues a suspended coroutine; any thread may call it.
+    void Post(std::coroutine_handle<> handle);
+
+    // Runs `task` on the workers without waiting for it.
+    void Spawn(ProtocolTask<> task);
+
+    // Waits until every spawned task has finished and rethrows the first exception one of
+    // them ended with.
+    void WaitIdle();
+
+    // The scheduler whose worker is running the calling thread, or nullptr.
+    static Scheduler *Current();
+
+    // co_await Schedule() moves the awaiting coroutine onto a worker.
+    auto Schedule() {
+        struct Awaiter {
+            Scheduler &scheduler;
+            bool await_ready() const noexcept {
+                return false;
+            }
+            void await_suspend(std::coroutine_handle<> handle) {
+                scheduler.Post(handle);
+            }
+            void await_resume() const noexcept {}
+        };
+        return Awaiter{*this};
+    }
+
+  private:
+    coroutine_detail::Detached RunDetached(ProtocolTask<> task);
+
+    void WorkerLoop();
+
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::deque<std::coroutine_handle<>> ready_;
+    bool stopping_ = false;
+
+    std::mutex idle_mutex_;
+    std::condition_variable idle_cv_;
+    int live_tasks_ = 0;
+    std::exception_ptr first_error_;
+
+    std::vector<std::thread> workers_;
+};
+
+// Result of CoReceive()/CoReceiveJmp(): registers a ReceiveAsync() continuation and resumes the
+// coroutine on its scheduler once the value is in. Throws like Receive() if the node stops.
+class ReceiveAwaiter {
+  public:
+    ReceiveAwaiter(NetworkNode &network_node, int task_id, int operation_id, size_t peer_count,
+                   std::optional<JmpSenders> senders = std::nullopt)
+        : network_node_(network_node),
+          task_id_(task_id),
+          operation_id_(operation_id),
+          peer_count_(peer_count),
+          senders_(senders) {}
+
+    bool await_ready() const noexcept {
+        return false;
+    }
+
+    bool await_suspend(std::coroutine_handle<> handle);
+
+    uint64_t await_resume() const;
+
+  private:
+    // Called by the continuation, or when the node drops it at Stop().
+    void Arrive();
+
+    NetworkNode &network_node_;
+    int task_id_;
+    int operation_id_;
+    size_t peer_count_;
+    std::optional<JmpSenders> senders_;
+
+    std::coroutine_handle<> handle_;
+    Scheduler *scheduler_ = nullptr;
+    uint64_t value_ = 0;
+    bool stopped_ = false;
+    // Set by whichever of await_suspend and the continuation finishes first; the second one
+    // resumes the coroutine.
+    std::atomic<bool> arrived_{false};
+};
+
+// co_await CoReceive(...) is the suspending counterpart of NetworkNode::Receive().
+inline ReceiveAwaiter CoReceive(NetworkNode &network_node, int task_id, int operation_id,
+                                size_t peer_count) {
+    return ReceiveAwaiter(network_node, task_id, operation_id, peer_count);
+}
+
+// Suspending counterpart of NetworkNode::ReceiveJmp().
+inline ReceiveAwaiter CoReceiveJmp(NetworkNode &network_node, int task_id, int operation_id,
+                                   const JmpSenders &senders) {
+    return ReceiveAwaiter(network_node, task_id, operation_id, 3, senders);
+}
+
+#endif
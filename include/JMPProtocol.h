@@ -4,6 +4,7 @@
 #include <cstdint>
 #include <vector>
 
+#include "Coroutine.h"
 #include "NetworkNode.h"
 #include "PCNode.h"
 
@@ -11,6 +12,10 @@ class JMPProtocol final {
   public:
     static void Handle(const std::vector<uint8_t> &data, Node &node, NetworkNode &network_node,
                        const TaskContext &ctx);
+
+    // Coroutine variant of Handle(); the receiver suspends until the value is in.
+    static ProtocolTask<> HandleAsync(std::vector<uint8_t> data, Node &node,
+                                      NetworkNode &network_node, TaskContext ctx);
 };
 
 uint64_t JMPFunc(uint64_t va, uint64_t vb, uint64_t vc);
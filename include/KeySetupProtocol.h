@@ -0,0 +1,24 @@
+#ifndef KEYSETUPPROTOCOL_H
+#define KEYSETUPPROTOCOL_H
+
+#include <memory>
+
+#include "NetworkNode.h"
+#include "PCNode.h"
+#include "SubsetKeys.h"
+
+// Key-setup phase: for every party subset, its lowest-numbered member samples a fresh PRF key
+// and sends it to the other members, so each party ends up with the keys of exactly the subsets
+// it belongs to. Run once per party; the keys can then serve any number of sessions.
+class KeySetupProtocol {
+  public:
+    // Uses operation ids ctx.operation_id .. ctx.operation_id + kOperationCount - 1.
+    static constexpr int kOperationCount = kAllParties;
+
+    // Installs the agreed keys on `node` and returns them for sharing with this party's other
+    // Nodes.
+    static std::shared_ptr<const SubsetKeys> Handle(Node &node, NetworkNode &network_node,
+                                                    const TaskContext &ctx);
+};
+
+#endif
@@ -0,0 +1,90 @@
+#ifndef LINKEMULATOR_H
+#define LINKEMULATOR_H
+
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Transport.h"
+
+struct LinkProfile {
+    double delay_ms = 0;       // one-way propagation delay
+    double jitter_ms = 0;      // uniform in [-jitter, +jitter], clamped at zero total delay
+    double bandwidth_mbps = 0;  // token-bucket rate; 0 means unlimited
+    size_t burst_bytes = 64 * 1024;
+};
+
+// Per-link profiles for this node's outgoing links, indexed by peer id.
+using LinkProfiles = std::array<LinkProfile, 6>;
+
+// Reads a profile file shared by all parties. Each non-comment line is
+//   <from> <to> <delay_ms> <jitter_ms> <bandwidth_mbps> [burst_bytes]
+// where from/to are party ids or "*". Later lines override earlier ones, so a "* * ..." default
+// can be followed by specific links. Only the lines with from == node_id (or *) apply.
+LinkProfiles LoadLinkProfiles(const std::string &path, int node_id);
+
+// Transport decorator that holds every outbound batch until its link would have delivered it:
+// the token bucket decides when the last byte leaves, then delay and jitter are added. Batches
+// on one link never overtake each other, as on a TCP connection. Receiving is passed through.
+class LinkEmulator : public Transport {
+  public:
+    LinkEmulator(std::unique_ptr<Transport> inner, const LinkProfiles &profiles,
+                 uint64_t seed = 1);
+    ~LinkEmulator() override;
+
+    void Send(int peer_id, PooledBuffer *batch) override;
+
+    bool Poll(std::chrono::milliseconds timeout, const BatchHandler &on_batch) override;
+
+    void Interrupt() override;
+
+    void WaitSent() override;
+
+  private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Pending {
+        Clock::time_point deliver_at;
+        uint64_t sequence;
+        int peer_id;
+        PooledBuffer *batch;
+
+        bool operator>(const Pending &other) const {
+            return deliver_at != other.deliver_at ? deliver_at > other.deliver_at
+                                                  : sequence > other.sequence;
+        }
+    };
+
+    struct LinkState {
+        double tokens = 0;
+        Clock::time_point refilled;
+        Clock::time_point last_delivery;
+    };
+
+    Clock::time_point Schedule(int peer_id, size_t bytes);
+
+    void DeliveryLoop();
+
+    std::unique_ptr<Transport> inner_;
+    LinkProfiles profiles_;
+    std::array<LinkState, 6> links_;
+    std::mt19937_64 rng_;
+
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::condition_variable sent_cv_;  // signalled when pending_ runs empty
+    bool delivering_ = false;          // a popped batch is being handed to inner_
+    std::priority_queue<Pending, std::vector<Pending>, std::greater<>> pending_;
+    uint64_t sequence_ = 0;
+    bool stopping_ = false;
+    std::thread delivery_;
+};
+
+#endif  // LINKEMULATOR_H
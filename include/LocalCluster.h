@@ -0,0 +1,65 @@
+#ifndef LOCALCLUSTER_H
+#define LOCALCLUSTER_H
+
+#include <array>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "MemoryTransport.h"
+#include "NetworkNode.h"
+#include "PCNode.h"
+
+struct ClusterReport {
+    std::string name;
+    int repetitions;
+    long long wall_us;
+    uint64_t rounds;  // Receive calls on the busiest party
+    uint64_t bytes;   // batch bytes sent by all five parties
+    std::array<uint64_t, 6> last_copies;  // by peer: three-copy receives it arrived last in
+    // Busy share of the wall time per dispatcher thread, averaged over the parties.
+    int dispatchers;
+    std::array<double, kMaxDispatchThreads> dispatcher_load;
+};
+
+using PartyStep = std::function<void(Node &node, NetworkNode &network_node, TaskContext &ctx)>;
+
+// All five parties in one process: each has its own Node and a NetworkNode on a shared
+// MemoryTransport hub, so protocol benchmarks need neither five processes nor sockets.
+class LocalCluster {
+  public:
+    explicit LocalCluster(uint32_t share_count, const NetworkOptions &options = {});
+    ~LocalCluster();
+
+    LocalCluster(const LocalCluster &) = delete;
+    LocalCluster &operator=(const LocalCluster &) = delete;
+
+    Node &GetNode(int id) {
+        return *nodes_.at(id);
+    }
+
+    NetworkNode &GetNetworkNode(int id) {
+        return *network_nodes_.at(id);
+    }
+
+    // Runs `step` on all parties concurrently, `repetitions` times each, and waits for all of
+    // them. Every party keeps its own TaskContext across calls. Exceptions are rethrown.
+    ClusterReport Run(const std::string &name, const PartyStep &step, int repetitions = 1);
+
+    // Runs the key-setup phase, so the parties' Nodes draw offline randomness from keys only
+    // their subsets hold instead of SubsetKeys::Default(). Call it before any offline step.
+    ClusterReport SetupKeys();
+
+    static void Print(const ClusterReport &report);
+
+  private:
+    std::shared_ptr<MemoryHub> hub_;
+    std::array<std::unique_ptr<Node>, 6> nodes_;
+    std::array<std::unique_ptr<NetworkNode>, 6> network_nodes_;
+    std::array<TaskContext, 6> contexts_{};
+    std::vector<std::thread> threads_;
+};
+
+#endif  // LOCALCLUSTER_H
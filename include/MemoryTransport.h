@@ -0,0 +1,59 @@
+#ifndef MEMORYTRANSPORT_H
+#define MEMORYTRANSPORT_H
+
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "Transport.h"
+
+// Mailboxes shared by the five MemoryTransports of one in-process cluster.
+class MemoryHub {
+  public:
+    struct Inbox {
+        std::mutex mutex;
+        std::condition_variable cv;
+        std::deque<std::vector<uint8_t>> batches;
+        bool interrupted = false;
+    };
+
+    Inbox &At(int node_id) {
+        return inboxes_.at(node_id);
+    }
+
+    uint64_t BytesSent() const {
+        return bytes_sent_.load(std::memory_order_relaxed);
+    }
+
+    void AddBytes(size_t bytes) {
+        bytes_sent_.fetch_add(bytes, std::memory_order_relaxed);
+    }
+
+  private:
+    std::array<Inbox, 6> inboxes_;
+    std::atomic<uint64_t> bytes_sent_{0};
+};
+
+// Delivers batches straight into the peer's mailbox. Batches are copied, so buffers never
+// cross between the nodes' pools and the nodes can be torn down in any order.
+class MemoryTransport : public Transport {
+  public:
+    MemoryTransport(int node_id, std::shared_ptr<MemoryHub> hub);
+
+    void Send(int peer_id, PooledBuffer *batch) override;
+
+    bool Poll(std::chrono::milliseconds timeout, const BatchHandler &on_batch) override;
+
+    void Interrupt() override;
+
+  private:
+    int node_id_;
+    std::shared_ptr<MemoryHub> hub_;
+    std::deque<std::vector<uint8_t>> ready_;
+};
+
+#endif  // MEMORYTRANSPORT_H
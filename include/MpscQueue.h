@@ -0,0 +1,134 @@
+#ifndef MPSCQUEUE_H
+#define MPSCQUEUE_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+// Bounded multi-producer / single-consumer ring (Vyukov-style sequenced cells).
+// Producers never drop: Push() spins briefly when the ring is full and then parks until the
+// consumer frees a slot, so a slow sender applies backpressure instead of losing messages.
+template <typename T>
+class MpscQueue {
+  public:
+    explicit MpscQueue(size_t capacity) {
+        size_t size = 2;
+        while (size < capacity) {
+            size <<= 1;
+        }
+        mask_ = size - 1;
+        cells_ = std::make_unique<Cell[]>(size);
+        for (size_t i = 0; i < size; ++i) {
+            cells_[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    MpscQueue(const MpscQueue &) = delete;
+    MpscQueue &operator=(const MpscQueue &) = delete;
+
+    bool TryPush(const T &item) {
+        size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+        for (;;) {
+            Cell &cell = cells_[pos & mask_];
+            const size_t seq = cell.sequence.load(std::memory_order_acquire);
+            const intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+            if (diff == 0) {
+                if (enqueue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    cell.data = item;
+                    cell.sequence.store(pos + 1, std::memory_order_release);
+                    UpdateHighWaterMark(pos + 1);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = enqueue_pos_.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // Blocks until the item is queued. Returns false only if `abort` becomes true first.
+    bool Push(const T &item, const std::atomic<bool> &abort) {
+        for (int spin = 0; spin < kSpinLimit; ++spin) {
+            if (TryPush(item)) {
+                return true;
+            }
+            std::this_thread::yield();
+        }
+
+        parks_.fetch_add(1, std::memory_order_relaxed);
+        std::unique_lock<std::mutex> lock(park_mutex_);
+        parked_.fetch_add(1, std::memory_order_seq_cst);
+        bool pushed = false;
+        while (!(pushed = TryPush(item)) && !abort.load()) {
+            // The timeout only guards against a missed notify; the consumer wakes us on pop.
+            not_full_cv_.wait_for(lock, std::chrono::milliseconds(1));
+        }
+        parked_.fetch_sub(1, std::memory_order_seq_cst);
+        return pushed;
+    }
+
+    bool TryPop(T &item) {
+        const size_t pos = dequeue_pos_.load(std::memory_order_relaxed);
+        Cell &cell = cells_[pos & mask_];
+        const size_t seq = cell.sequence.load(std::memory_order_acquire);
+        if (static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos + 1) < 0) {
+            return false;
+        }
+        item = cell.data;
+        dequeue_pos_.store(pos + 1, std::memory_order_relaxed);
+        cell.sequence.store(pos + mask_ + 1, std::memory_order_release);
+
+        if (parked_.load(std::memory_order_seq_cst) > 0) {
+            std::lock_guard<std::mutex> lock(park_mutex_);
+            not_full_cv_.notify_all();
+        }
+        return true;
+    }
+
+    size_t Capacity() const {
+        return mask_ + 1;
+    }
+
+    size_t HighWaterMark() const {
+        return high_water_mark_.load(std::memory_order_relaxed);
+    }
+
+    uint64_t Parks() const {
+        return parks_.load(std::memory_order_relaxed);
+    }
+
+  private:
+    static constexpr int kSpinLimit = 64;
+
+    struct Cell {
+        std::atomic<size_t> sequence;
+        T data;
+    };
+
+    void UpdateHighWaterMark(const size_t enqueued) {
+        const size_t dequeued = dequeue_pos_.load(std::memory_order_relaxed);
+        const size_t depth = enqueued > dequeued ? enqueued - dequeued : 0;
+        size_t current = high_water_mark_.load(std::memory_order_relaxed);
+        while (depth > current &&
+               !high_water_mark_.compare_exchange_weak(current, depth, std::memory_order_relaxed)) {
+        }
+    }
+
+    std::unique_ptr<Cell[]> cells_;
+    size_t mask_ = 0;
+    alignas(64) std::atomic<size_t> enqueue_pos_{0};
+    alignas(64) std::atomic<size_t> dequeue_pos_{0};
+    alignas(64) std::atomic<size_t> high_water_mark_{0};
+    std::atomic<uint64_t> parks_{0};
+    std::atomic<int> parked_{0};
+    std::mutex park_mutex_;
+    std::condition_variable not_full_cv_;
+};
+
+#endif  // MPSCQUEUE_H
@@ -2,8 +2,10 @@
 #define MULPROTOCOL_H
 
 #include <cstdint>
+#include <type_traits>
 #include <vector>
 
+#include "Coroutine.h"
 #include "NetworkNode.h"
 #include "PCNode.h"
 
@@ -47,6 +49,13 @@ class ModularCalculator {
         return Policy::zero();
     }
 
+    // JMP send of a share; boolean-ring shares travel as packed bit frames.
+    static void SendJmp(NetworkNode &network_node, int peer_id, int task_id, int operation_id,
+                        uint64_t value, const JmpSenders &senders) {
+        network_node.SendJmp(peer_id, task_id, operation_id, value, senders,
+                             std::is_same_v<Policy, Mod2Policy>);
+    }
+
     template <typename Iterator>
     static uint64_t accumulate(Iterator begin, Iterator end) {
         uint64_t result = zero();
@@ -78,6 +87,25 @@ class MulOnProtocol {
     template <class Calculator>
     void HandleImpl(const std::vector<uint8_t> &data, Node &node, NetworkNode &network_node,
                     const TaskContext &ctx);
+
+    // Coroutine variant of Handle(): suspends on the JMP receive instead of blocking.
+    static ProtocolTask<> HandleAsync(std::vector<uint8_t> data, Node &node,
+                                      NetworkNode &network_node, TaskContext ctx);
+
+  private:
+    template <class Calculator>
+    static ProtocolTask<> HandleAsyncImpl(std::vector<uint8_t> data, Node &node,
+                                          NetworkNode &network_node, TaskContext ctx);
+
+    // Computes the beta_z shares and sends the ones this party holds for the others.
+    template <class Calculator>
+    static void SendBetaZ(const std::vector<uint8_t> &data, Node &node, NetworkNode &network_node,
+                          const TaskContext &ctx, uint64_t (&beta_z)[5]);
+
+    // Sets beta_z once this party's own entry has been received.
+    template <class Calculator>
+    static void CombineBetaZ(const std::vector<uint8_t> &data, Node &node,
+                             const uint64_t (&beta_z)[5]);
 };
 
 class MulOffJointSharingPrepareProtocol {
@@ -1,49 +1,331 @@
 #ifndef NETWORKNODE_H
 #define NETWORKNODE_H
 
+#include <array>
 #include <atomic>
-#include <boost/lockfree/queue.hpp>
 #include <chrono>
 #include <cinttypes>
 #include <condition_variable>
 #include <deque>
+#include <functional>
+#include <future>
 #include <mutex>
+#include <optional>
 #include <shared_mutex>
+#include <span>
+#include <string>
+#include <thread>
 #include <unordered_map>
-#include <zmq.hpp>
+#include <vector>
+
+#include "BufferPool.h"
+#include "MpscQueue.h"
+#include "Transport.h"
+#include "WireFormat.h"
 
-constexpr size_t MSG_SIZE = 100;
 constexpr int BATCH_SIZE = 50;
 constexpr int WAIT_TIME = 10;
 
+constexpr int kMaxDispatchThreads = 8;
+
+// Online messages are latency-critical; bulk ones (offline preprocessing) only need throughput.
+enum class TrafficClass { kOnline, kBulk };
+
+// Messages added on this thread while the scope is alive travel in `traffic_class`. The offline
+// protocols open a kBulk scope themselves; scopes nest.
+class TrafficClassScope {
+  public:
+    explicit TrafficClassScope(TrafficClass traffic_class);
+    ~TrafficClassScope();
+
+    TrafficClassScope(const TrafficClassScope&) = delete;
+    TrafficClassScope& operator=(const TrafficClassScope&) = delete;
+
+    static TrafficClass Current();
+
+  private:
+    TrafficClass previous_;
+};
+
+// Task id reserved for the WaitForPeers()/Drain() handshakes.
+constexpr int kControlTaskId = -1;
+
+// Straggler histogram buckets: bucket 0 is under 1 us, bucket b covers [2^(b-1), 2^b) us and
+// the last one is open-ended.
+constexpr int kStragglerBuckets = 24;
+
 inline static const std::unordered_map<int, std::string> default_node_addresses = {
     {1, "tcp://127.0.0.1:5551"}, {2, "tcp://127.0.0.1:5552"}, {3, "tcp://127.0.0.1:5553"},
     {4, "tcp://127.0.0.1:5554"}, {5, "tcp://127.0.0.1:5555"},
 };
 
+enum class ReceiveMode : uint8_t {
+    kBusyPoll,  // zero-timeout poll in a tight loop
+    kAdaptive,  // spin for spin_budget empty polls, then block until a message or Stop()
+    kBlocking,  // always block on the poller
+};
+
+struct NetworkOptions {
+    ReceiveMode receive_mode = ReceiveMode::kAdaptive;
+    int spin_budget = 2000;
+    size_t send_queue_capacity = 4096;  // per peer
+    int sender_threads = 1;             // outgoing links are sharded across this many senders
+    bool auto_flush = true;  // Receive() flushes pending sends before it waits
+    std::string link_profile;  // if set, outgoing links are shaped by a LinkEmulator
+    // SendJmp() ships only the designated copy; the other two senders fold theirs into a digest
+    // that VerifyJmp() checks. Must be the same on all parties.
+    bool jmp_digests = false;
+    // Receive(..., 3) returns as soon as two identical copies are in; the third is checked
+    // against them when it arrives.
+    bool early_accept = false;
+    // 0: the receive thread dispatches every batch itself. Otherwise it hands batches to this
+    // many dispatcher threads (at most kMaxDispatchThreads), each owning a shard of task ids.
+    int dispatch_threads = 0;
+    // Bulk messages get their own per-peer queues and batches. Online batches always go out
+    // first, and at most this many bulk batches may sit in the transport at a time, so an
+    // online batch never queues behind a bulk backlog. 0 sends everything in one FIFO.
+    int bulk_batches_in_flight = 4;
+};
+
+struct DispatcherStats {
+    uint64_t batches;
+    uint64_t busy_us;     // time spent dispatching
+    uint64_t running_us;  // time since the dispatcher started; busy_us / running_us is its load
+};
+
+struct NetworkStats {
+    uint64_t spin_iterations;   // zero-timeout polls that found nothing
+    uint64_t blocking_wakeups;  // returns from a blocking poll
+    size_t send_queue_high_water_mark;
+    uint64_t send_queue_parks;  // producers that had to wait for the sender to free space
+    uint64_t batches_sent;
+    uint64_t bytes_sent;
+    uint64_t send_buffer_allocations;  // batch buffers the pool had to create
+    uint64_t receive_calls;            // Receive/ReceiveVector calls, i.e. rounds waited on
+    size_t task_queues;                // tasks currently holding a receive queue
+    uint64_t jmp_copies_digested;      // JMP copies replaced by a running digest
+    uint64_t jmp_mismatches;           // digests that disagreed at a VerifyJmp() checkpoint
+    uint64_t early_accepts;            // three-copy receives completed on two copies
+    uint64_t late_copies;              // third copies checked after an early accept
+    uint64_t late_mismatches;          // late copies that disagreed with the accepted value
+    // Per peer: how often its copy came last in a three-copy receive, by how long it trailed
+    // the second copy.
+    std::array<std::array<uint64_t, kStragglerBuckets>, 6> stragglers;
+    // One entry per dispatcher thread; with dispatch_threads == 0 entry 0 is the receive thread.
+    int dispatchers;
+    std::array<DispatcherStats, kMaxDispatchThreads> dispatcher_stats;
+    uint64_t bulk_batches_sent;
+    uint64_t bulk_throttles;  // sender passes that left bulk queued to keep the link free
+};
+
 struct TaskContext {
     int task_id;
     int operation_id;
 };
 
+// A queued outbound payload: either a single value, or a block of `count` values that the
+// queue owns until the sender has encoded it. `bits` marks boolean shares, sent packed.
+struct OutboundMessage {
+    int peer_id;
+    int task_id;
+    int operation_id;
+    uint32_t count;
+    uint64_t value;
+    uint64_t *values;
+    bool bits = false;
+};
+
+struct ValueOrigin {
+    int sender;
+    std::chrono::steady_clock::time_point arrived;
+};
+
+// The copy still owed to an early-accepted majority receive.
+struct LateCopy {
+    std::array<int, 2> contributors;
+    uint64_t value;
+    std::chrono::steady_clock::time_point accepted_at;
+};
+
+// Continuation registered by ReceiveAsync(), run once its value can be taken.
+struct PendingReceive {
+    size_t peer_count;
+    std::function<void(uint64_t)> done;
+};
+
+// Continuations taken off their operation, with their values, to be run outside the task lock.
+using ReadyReceives = std::vector<std::pair<std::function<void(uint64_t)>, uint64_t>>;
+
+// Values received for one operation id. Receivers consume from `consumed` onwards instead of
+// erasing from the front, and wait on the operation's own condition variable.
+struct OperationBuffer {
+    std::vector<uint64_t> values;
+    std::vector<ValueOrigin> origins;  // parallel to values
+    size_t consumed = 0;
+    int waiters = 0;
+    std::condition_variable cv;
+    std::optional<LateCopy> late;
+    std::deque<PendingReceive> pending;  // oldest first
+
+    size_t Available() const {
+        return values.size() - consumed;
+    }
+
+    // Nothing left to read, wait for or check: the entry can be erased.
+    bool Idle() const {
+        return values.empty() && waiters == 0 && !late && pending.empty();
+    }
+};
+
+// The three parties that jointly send a value in a JMP round.
+using JmpSenders = std::array<int, 3>;
+
+// Running digest over the JMP copies exchanged with one peer in one task.
+struct JmpChain {
+    std::array<uint8_t, 32> digest{};
+    std::vector<uint64_t> values;  // kept until VerifyJmp() in case full copies are needed
+};
+
+// A designated value accepted by ReceiveJmp(), located in the chains of its digest senders.
+struct JmpEntry {
+    std::array<int, 2> senders;
+    std::array<uint32_t, 2> positions;
+};
+
+// Digest-mode JMP bookkeeping for one task since its last VerifyJmp().
+struct JmpState {
+    std::array<JmpChain, 6> sent;      // by receiver: copies this party only digested
+    std::array<JmpChain, 6> received;  // by digest sender: designated values accepted
+    std::vector<JmpEntry> accepted;
+};
+
 struct TaskQueue {
-    std::deque<std::pair<int, std::vector<uint64_t>>> data;
+    std::unordered_map<int, OperationBuffer> operations;
+    std::mutex mutex;
+    bool closed = false;  // unlinked from task_queues_; writers must look the task up again
+    bool close_requested = false;  // CloseTask() found it busy; retried when a late copy drains it
+};
+
+// Outbound state for one peer. Only the sender thread owning the peer's shard pops the queue,
+// fills the writer and touches the peer's dealer socket.
+struct PeerChannel {
+    explicit PeerChannel(size_t capacity) : queue(capacity), bulk_queue(capacity) {}
+
+    MpscQueue<OutboundMessage> queue;
+    MpscQueue<OutboundMessage> bulk_queue;
+    FrameWriter writer;
+};
+
+// Inbound side of one dispatcher thread. The receive thread is the only producer.
+struct Dispatcher {
+    explicit Dispatcher(size_t capacity) : queue(capacity) {}
+
+    MpscQueue<PooledBuffer*> queue;
+    std::mutex mutex;
     std::condition_variable cv;
+    std::atomic<bool> sleeping{false};
+    std::atomic<uint64_t> batches{0};
+    std::atomic<uint64_t> busy_ns{0};
+    const std::chrono::steady_clock::time_point started = std::chrono::steady_clock::now();
+};
+
+struct SenderShard {
+    std::vector<int> peers;
     std::mutex mutex;
+    std::condition_variable cv;
+    std::atomic<size_t> pending{0};
+    std::atomic<size_t> bulk_pending{0};  // queued in the peers' bulk queues
+    std::atomic<bool> bulk_throttled{false};  // waiting for a bulk batch to leave the transport
+    std::atomic<bool> flush_requested{false};
 };
 
 class NetworkNode {
   public:
     NetworkNode(
         int id, int io_threads,
-        const std::unordered_map<int, std::string>& node_addresses = default_node_addresses);
+        const std::unordered_map<int, std::string>& node_addresses = default_node_addresses,
+        const NetworkOptions& options = {});
+
+    // Runs on a caller-provided transport instead of the one chosen from the addresses.
+    NetworkNode(int id, std::unique_ptr<Transport> transport, const NetworkOptions& options = {});
+
+    // Frees the value blocks of messages still queued when the senders stopped.
+    ~NetworkNode();
 
     void AddMessage(int peer_id, int task_id, int operation_id, uint64_t value);
 
+    // Sends a whole block of values to one peer under a single operation id.
+    void AddMessages(int peer_id, int task_id, int operation_id, std::span<const uint64_t> values);
+
+    // Sends a boolean share packed into a bit frame; Receive() returns it as 0 or 1. Values
+    // wider than one bit fall back to AddMessage so nothing is silently truncated.
+    void AddBit(int peer_id, int task_id, int operation_id, uint64_t bit);
+
+    // Drives the outgoing links. With options.sender_threads > 1 this spawns the additional
+    // sender threads itself and joins them on Stop().
     void SendMessages();
 
+    // Marks a round boundary: the sender ships everything queued so far without waiting for a
+    // full batch or WAIT_TIME.
+    void Flush();
+
     uint64_t Receive(int task_id, int operation_id, size_t peer_count);
 
+    // Non-blocking Receive(): `done` gets the value on the thread that dispatches it, or on the
+    // caller's thread if it is already here. It must not block or throw; waits on one
+    // operation are served in order, so do not mix it with Receive() on the same operation.
+    // Continuations still pending at Stop() are dropped without being called.
+    void ReceiveAsync(int task_id, int operation_id, size_t peer_count,
+                      std::function<void(uint64_t)> done);
+
+    // Future flavour of the above; after Stop() the future holds a broken_promise error.
+    std::future<uint64_t> ReceiveAsync(int task_id, int operation_id, size_t peer_count);
+
+    // Receives out.size() values from each of peer_count senders and writes the element-wise
+    // JMP majority (or the single copy when peer_count == 1) into out.
+    void ReceiveVector(int task_id, int operation_id, std::span<uint64_t> out, size_t peer_count);
+
+    // Sends this party's copy of a value that all of `senders` hold. With options.jmp_digests
+    // only the designated sender transmits it; the others fold it into a running digest for
+    // (peer, task). `bit` sends the value as a boolean share.
+    void SendJmp(int peer_id, int task_id, int operation_id, uint64_t value,
+                 const JmpSenders& senders, bool bit = false);
+
+    // Receiving side of SendJmp(): the majority of the three copies, or with jmp_digests the
+    // designated copy, accepted optimistically until VerifyJmp().
+    uint64_t ReceiveJmp(int task_id, int operation_id, const JmpSenders& senders);
+
+    // ReceiveJmp() with a ReceiveAsync() continuation.
+    void ReceiveJmpAsync(int task_id, int operation_id, const JmpSenders& senders,
+                         std::function<void(uint64_t)> done);
+
+    // Checkpoint for digest-mode JMP in `task_id`. All parties swap their running digests, full
+    // copies are fetched only from senders whose digest disagrees, and those are voted against
+    // the accepted values. Returns false if a designated value was outvoted or a sender sent
+    // the wrong number of copies; results computed since the last checkpoint must then be
+    // discarded. Uses operation ids operation_id + 1 to operation_id + 15. Without jmp_digests
+    // it returns true at once.
+    bool VerifyJmp(int task_id, int operation_id);
+
+    // Startup barrier: returns once every other party has said hello, i.e. all five are up and
+    // connected. Messages sent earlier are not lost either way; this only replaces the fixed
+    // sleeps that used to line the parties up.
+    void WaitForPeers();
+
+    // Shutdown barrier: returns once every peer has confirmed receiving everything this party
+    // sent, every peer's traffic to this party is in, and nothing is left in the outgoing
+    // queues or the transport. Call it after the last protocol step and before Stop().
+    void Drain();
+
+    // Task lifecycle. OpenTask is optional (queues are also created on first use). CloseTask
+    // reclaims the task's receive queue once it is drained; values still unread can only belong
+    // to a later use of the same task id by a faster peer, so such a queue is kept. A queue that
+    // is only owed late copies is reclaimed once they arrive. JMP digests of the task that were
+    // never verified are discarded.
+    void OpenTask(int task_id);
+
+    void CloseTask(int task_id);
+
     void ReceiveMessages();
 
     void Stop();
@@ -52,25 +334,126 @@ class NetworkNode {
         return node_id_;
     }
 
+    NetworkStats Stats() const;
+
   private:
     static uint64_t Jmp(uint64_t va, uint64_t vb, uint64_t vc);
 
+    // The sender that transmits the value to `peer_id` in digest mode; rotating it by receiver
+    // spreads the full copies over all three senders.
+    static int JmpDesignated(int peer_id, JmpSenders senders);
+
     std::shared_ptr<TaskQueue> GetOrCreateTaskQueue(int task_id);
 
+    void Enqueue(const OutboundMessage& msg);
+
+    void SenderLoop(SenderShard& shard);
+
+    // Pops up to `limit` messages into a fresh batch in `writer`; returns how many.
+    size_t EncodeBatch(MpscQueue<OutboundMessage>& queue, FrameWriter& writer, size_t limit);
+
+    void SendBatch(int peer_id, FrameWriter& writer, BufferPool& pool);
+
+    void Collect(int task_id, int operation_id, size_t total, uint64_t* dst);
+
+    uint64_t ReceiveMajority(int task_id, int operation_id);
+
+    // Books a designated JMP copy into the digest chains that VerifyJmp() checks.
+    void AcceptJmp(int task_id, int operation_id, const JmpSenders& senders, uint64_t value);
+
+    // True if a receive from peer_count senders can complete on op's values now.
+    bool CanTake(const OperationBuffer& op, size_t peer_count) const;
+
+    // Consumes the values of one receive; CanTake() must hold. Caller holds the task lock.
+    uint64_t Take(OperationBuffer& op, size_t peer_count);
+
+    // Moves the continuations that op's values now satisfy into `ready`.
+    void ServePending(OperationBuffer& op, ReadyReceives& ready);
+
+    void RunContinuations(ReadyReceives& ready);
+
+    // One all-to-all round on the control task.
+    void ExchangeControl(int operation_id);
+
+    // Returns the task's live queue with `lock` holding its mutex.
+    std::shared_ptr<TaskQueue> LockTaskQueue(int task_id, std::unique_lock<std::mutex>& lock);
+
+    void ReclaimTaskQueue(int task_id);
+
+    void RecordStraggler(int sender, std::chrono::steady_clock::duration lateness);
+
+    // Queues the frames of `data` into the task queues; with shard >= 0 only the frames of
+    // tasks owned by that dispatcher.
+    void DispatchBatch(const void* data, size_t size, int shard = -1);
+
+    int ShardOf(int task_id) const {
+        return static_cast<int>(static_cast<uint32_t>(task_id) % dispatchers_.size());
+    }
+
+    // Copies a received batch and hands it to the dispatchers owning its tasks.
+    void RouteBatch(const void* data, size_t size);
+
+    void DispatcherLoop(Dispatcher& dispatcher, int shard);
+
     int node_id_;
-    zmq::context_t context_;
-    zmq::socket_t router_;
+    NetworkOptions options_;
+    // Declared before the transport so that buffers it still holds are returned before the
+    // pool goes away, and before the senders those returns wake.
+    std::vector<std::unique_ptr<SenderShard>> shards_;
+    BufferPool send_buffers_;
+    // Bulk batches come from their own pool, whose InUse() counts those still in the transport.
+    BufferPool bulk_buffers_;
+    std::unique_ptr<Transport> transport_;
     std::atomic<bool> stop_flag_;
-    zmq::socket_t exit_pair_{context_, ZMQ_PAIR};
-    std::unordered_map<int, zmq::socket_t> dealers_;
+    std::atomic<uint64_t> spin_iterations_{0};
+    std::atomic<uint64_t> blocking_wakeups_{0};
+    std::atomic<uint64_t> batches_sent_{0};
+    std::atomic<uint64_t> bytes_sent_{0};
+    std::atomic<uint64_t> bulk_batches_sent_{0};
+    std::atomic<uint64_t> bulk_throttles_{0};
+    std::atomic<uint64_t> receive_calls_{0};
+    std::atomic<uint64_t> jmp_copies_digested_{0};
+    std::atomic<uint64_t> jmp_mismatches_{0};
+    std::atomic<uint64_t> early_accepts_{0};
+    std::atomic<uint64_t> late_copies_{0};
+    std::atomic<uint64_t> late_mismatches_{0};
+    std::array<std::array<std::atomic<uint64_t>, kStragglerBuckets>, 6> stragglers_{};
 
-    std::mutex send_data_mutex_;
-    std::condition_variable send_data_cv_;
-    std::atomic<size_t> total_msg_count_{0};
-    boost::lockfree::queue<std::array<char, MSG_SIZE>> lockfree_queue_{2000};
+    std::array<std::unique_ptr<PeerChannel>, 6> channels_;
+    std::array<SenderShard*, 6> peer_shards_{};
+
+    BufferPool inbound_buffers_;
+    std::vector<std::unique_ptr<Dispatcher>> dispatchers_;
+    // Dispatch time of the receive thread itself when there are no dispatchers.
+    std::atomic<uint64_t> inline_batches_{0};
+    std::atomic<uint64_t> inline_busy_ns_{0};
+    std::chrono::steady_clock::time_point receive_started_;
 
     mutable std::shared_mutex map_mutex_;
     std::unordered_map<int, std::shared_ptr<TaskQueue>> task_queues_;
+
+    std::mutex jmp_mutex_;
+    std::unordered_map<int, JmpState> jmp_states_;
+};
+
+// Opens a task for the lifetime of the scope and closes it on exit.
+class TaskSession {
+  public:
+    TaskSession(NetworkNode &network_node, int task_id)
+        : network_node_(network_node), task_id_(task_id) {
+        network_node_.OpenTask(task_id_);
+    }
+
+    ~TaskSession() {
+        network_node_.CloseTask(task_id_);
+    }
+
+    TaskSession(const TaskSession &) = delete;
+    TaskSession &operator=(const TaskSession &) = delete;
+
+  private:
+    NetworkNode &network_node_;
+    int task_id_;
 };
 
 #endif  // NETWORKNODE_H
@@ -3,14 +3,16 @@
 
 #include <cstdint>
 #include <iostream>
+#include <map>
 #include <string>
 
-#include <openssl/aes.h>
-#include <openssl/err.h>
 #include <spdlog/spdlog.h>
 
 #include "CipherData.h"
 #include "Matrix.h"
+#include "Prf.h"
+#include "ShareStore.h"
+#include "SubsetKeys.h"
 #include "Util.h"
 #include "spdlog/fmt/ranges.h"
 
@@ -18,9 +20,54 @@ class Node {
   public:
     Node(uint8_t id, uint32_t share_count);
 
+    // Keys PRFEval with `key` and derives every subset key from it (see SubsetKeys::Derive).
     void SetKey(const std::vector<uint8_t> &key);
 
-    uint64_t PRFEval(uint64_t input) const;
+    // The plain PRF under the SetKey() key (all ones by default), outside any session. The
+    // offline protocols draw from SubsetRandom() instead.
+    uint64_t PRFEval(const uint64_t input) const {
+        return prf_.Eval(input);
+    }
+
+    // out[i] = PRFEval(first_input + i) for i < count.
+    void PRFEvalBatch(const uint64_t first_input, const std::size_t count, uint64_t *out) const {
+        prf_.EvalBatch(first_input, count, out);
+    }
+
+    // Installs keys agreed in a key-setup phase; may be shared by all of this party's Nodes.
+    void SetSubsetKeys(std::shared_ptr<const SubsetKeys> keys) {
+        subset_keys_ = std::move(keys);
+    }
+
+    // Starts a session: later randomness uses `nonce` and the counters of every domain restart
+    // at zero. Concurrent sessions under the same keys need distinct nonces (e.g. task ids).
+    void SetSession(const uint64_t nonce) {
+        session_nonce_ = nonce;
+        next_counters_.fill(0);
+    }
+
+    // Reserves `count` counters of `domain` and returns the first. Every party must reserve the
+    // same amounts in the same order within a session, so offline protocols reserve before
+    // branching on the party id.
+    uint64_t ReserveCounters(const RandomDomain domain, const uint64_t count) {
+        uint64_t &next = next_counters_[static_cast<size_t>(domain)];
+        const uint64_t first = next;
+        next += count;
+        return RandomCounter(domain, first);
+    }
+
+    // out[i] = PRF of `subset`'s key on (session nonce, first_counter + i), a value shared by
+    // exactly the members of `subset`.
+    void SubsetRandom(const PartySet subset, const uint64_t first_counter, const std::size_t count,
+                      uint64_t *out) const {
+        subset_keys_->Generate(subset, session_nonce_, first_counter, count, out);
+    }
+
+    uint64_t SubsetRandom(const PartySet subset, const uint64_t counter) const {
+        uint64_t out;
+        SubsetRandom(subset, counter, 1, &out);
+        return out;
+    }
 
     void InitializeMaps(uint32_t count);
 
@@ -98,32 +145,41 @@ class Node {
         return val_;
     }
 
-    const std::unordered_map<uint32_t, CipherData> &GetBetaSharesMap() const {
+    const ShareStore<CipherData> &GetBetaSharesMap() const {
         return beta_shares_map_;
     }
 
     std::unordered_map<uint32_t, CipherData> GetBetaSharesMapCopy() const {
-        return beta_shares_map_;
+        std::unordered_map<uint32_t, CipherData> copy;
+        copy.reserve(beta_shares_map_.size());
+        beta_shares_map_.ForEach([&](uint32_t id, const CipherData &share) { copy[id] = share; });
+        return copy;
     }
 
     uint64_t &Values(const uint32_t id, bool create_if_missing = false) {
         if (create_if_missing) {
             return values_map_[id];
         }
-        const auto it = values_map_.find(id);
-        if (it != values_map_.end()) {
-            return it->second;
+        if (uint64_t *value = values_map_.Find(id)) {
+            return *value;
         }
         throw std::runtime_error("Value not found for ID: " + std::to_string(id));
     }
 
+    // Read-only lookup; unlike the mutable one it never copies a shared share into this node.
+    const CipherData &BetaShares(const uint32_t id) const {
+        if (const CipherData *share = beta_shares_map_.Find(id)) {
+            return *share;
+        }
+        throw std::runtime_error("Beta share not found for ID: " + std::to_string(id));
+    }
+
     CipherData &BetaShares(const uint32_t id, bool create_if_missing = false) {
         if (create_if_missing) {
             return beta_shares_map_[id];
         }
-        const auto it = beta_shares_map_.find(id);
-        if (it != beta_shares_map_.end()) {
-            return it->second;
+        if (CipherData *share = beta_shares_map_.Find(id)) {
+            return *share;
         }
         throw std::runtime_error("Beta share not found for ID: " + std::to_string(id));
     }
@@ -132,9 +188,8 @@ class Node {
         if (create_if_missing) {
             return additive_shares_map_[id];
         }
-        const auto it = additive_shares_map_.find(id);
-        if (it != additive_shares_map_.end()) {
-            return it->second;
+        if (auto *shares = additive_shares_map_.Find(id)) {
+            return *shares;
         }
         throw std::runtime_error("Additive share not found for ID: " + std::to_string(id));
     }
@@ -217,6 +272,12 @@ class Node {
         beta_shares_map_[id] = beta_share;
     }
 
+    // Reads beta shares this node does not hold from `shared`, an immutable store that many
+    // Nodes can reference at once (e.g. one layer's model weights) instead of each copying it.
+    void SetSharedBetaShares(std::shared_ptr<const ShareStore<CipherData>> shared) {
+        beta_shares_map_.SetBase(std::move(shared));
+    }
+
     void ResetBetaShares() {
         beta_shares_map_.clear();
     }
@@ -260,7 +321,10 @@ class Node {
 
   private:
     uint8_t id_;
-    AES_KEY aes_key_{};
+    Prf prf_;
+    std::shared_ptr<const SubsetKeys> subset_keys_ = SubsetKeys::Default();
+    uint64_t session_nonce_ = 0;
+    std::array<uint64_t, kRandomDomainCount> next_counters_{};
 
     uint64_t t_{};           // JMP protocol buffer
     uint64_t reshare_[5]{};  // ReSharing protocol buffer
@@ -269,9 +333,9 @@ class Node {
     struct CipherData cipher_ {};  // [[alpha]] and beta
     Matrix matrix_{5};             // Mul protocol buffer
 
-    std::unordered_map<uint32_t, uint64_t> values_map_;
-    std::unordered_map<uint32_t, CipherData> beta_shares_map_;
-    std::unordered_map<uint32_t, uint64_t[5]> additive_shares_map_;
+    ShareStore<uint64_t> values_map_;
+    ShareStore<CipherData> beta_shares_map_;
+    ShareStore<uint64_t[5]> additive_shares_map_;
 
     std::unordered_map<uint8_t, std::pair<CipherData, CipherData>> truncation_params_;
     std::unordered_map<uint8_t, uint64_t[64][5]> a2b_shares_map_;
@@ -0,0 +1,43 @@
+#ifndef PRF_H
+#define PRF_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include <openssl/aes.h>
+
+// AES-128 PRF on 64-bit inputs: the input is the little-endian low half of an otherwise zero
+// block and the result is the low half of its encryption. CtrBatch is the same with a nonce in
+// the high half, i.e. an AES-CTR keystream truncated to 64 bits per block. On CPUs with AES-NI,
+// batches keep eight blocks in flight through the rounds; elsewhere they fall back to OpenSSL's
+// AES_encrypt. Both paths give identical results, so parties may mix them.
+class Prf {
+  public:
+    static constexpr size_t kKeySize = 16;
+
+    // Expands the 16-byte key.
+    void SetKey(const uint8_t *key);
+
+    uint64_t Eval(uint64_t input) const {
+        uint64_t out;
+        EvalBatch(input, 1, &out);
+        return out;
+    }
+
+    // out[i] = Eval(first_input + i) for i < count, without heap allocation.
+    void EvalBatch(uint64_t first_input, size_t count, uint64_t *out) const {
+        CtrBatch(0, first_input, count, out);
+    }
+
+    // out[i] = low half of AES(nonce || first_counter + i) for i < count.
+    void CtrBatch(uint64_t nonce, uint64_t first_counter, size_t count, uint64_t *out) const;
+
+    // Whether the batches use AES-NI on this CPU.
+    static bool HasAesNi();
+
+  private:
+    alignas(16) uint8_t round_keys_[11][16]{};  // AES-NI key schedule
+    AES_KEY aes_key_{};                         // OpenSSL key schedule for the fallback
+};
+
+#endif  // PRF_H
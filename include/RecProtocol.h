@@ -4,6 +4,7 @@
 #include <cstdint>
 #include <vector>
 
+#include "Coroutine.h"
 #include "NetworkNode.h"
 #include "PCNode.h"
 
@@ -11,6 +12,14 @@ class ReconstructionProtocol final {
   public:
     static void Handle(const std::vector<uint8_t> &data, Node &node, NetworkNode &network_node,
                        const TaskContext &ctx);
+
+    // Coroutine variant of Handle().
+    static ProtocolTask<> HandleAsync(std::vector<uint8_t> data, Node &node,
+                                      NetworkNode &network_node, TaskContext ctx);
+
+  private:
+    // Receiver side, once the missing alpha share has arrived in node.T().
+    static void Reconstruct(const std::vector<uint8_t> &data, Node &node);
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,185 @@
+#ifndef SHARESTORE_H
+#define SHARESTORE_H
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+// Slot-indexed store for values keyed by small dense ids, replacing unordered_map<uint32_t, T>
+// in Node. Slots live in fixed-size pages allocated on first touch, so a lookup is two array
+// indexings and a bit test, and neighbouring ids (a weight row, an input vector) sit next to
+// each other in memory. A presence bitmap per page tells stored slots from untouched ones.
+//
+// A store can be layered over an immutable base store (SetBase), such as a model's weight shares
+// shared by every per-neuron Node: reads fall through to the base for ids this store does not
+// hold, and the first mutable access to such an id copies it into this store, so the base is
+// never written.
+template <typename T>
+class ShareStore {
+  public:
+    static constexpr uint32_t kPageBits = 10;
+    static constexpr uint32_t kPageSize = 1u << kPageBits;
+
+    ShareStore() = default;
+    ShareStore(ShareStore &&) noexcept = default;
+    ShareStore &operator=(ShareStore &&) noexcept = default;
+
+    ShareStore(const ShareStore &other) : base_(other.base_), size_(other.size_) {
+        pages_.resize(other.pages_.size());
+        for (size_t i = 0; i < pages_.size(); ++i) {
+            if (other.pages_[i]) {
+                pages_[i] = std::make_unique<Page>(*other.pages_[i]);
+            }
+        }
+    }
+
+    ShareStore &operator=(const ShareStore &other) {
+        if (this != &other) {
+            *this = ShareStore(other);
+        }
+        return *this;
+    }
+
+    // Reads through to `base` for ids not stored here. The base must outlive its last reader
+    // and must not change while attached.
+    void SetBase(std::shared_ptr<const ShareStore> base) {
+        base_ = std::move(base);
+    }
+
+    // The slot for `id`, or nullptr if neither this store nor its base holds it. An id found
+    // only in the base is copied into this store first.
+    T *Find(uint32_t id) {
+        if (T *own = FindOwn(id)) {
+            return own;
+        }
+        const T *shared = base_ ? base_->Find(id) : nullptr;
+        if (shared == nullptr) {
+            return nullptr;
+        }
+        T &slot = Claim(id);
+        if constexpr (std::is_array_v<T>) {
+            std::copy(std::begin(*shared), std::end(*shared), std::begin(slot));
+        } else {
+            slot = *shared;
+        }
+        return &slot;
+    }
+
+    const T *Find(uint32_t id) const {
+        if (const T *own = FindOwn(id)) {
+            return own;
+        }
+        return base_ ? base_->Find(id) : nullptr;
+    }
+
+    bool Contains(uint32_t id) const {
+        return Find(id) != nullptr;
+    }
+
+    // The slot for `id`, marked present if it was not yet, like unordered_map::operator[]. A new
+    // slot starts as the base's value for `id`, or value-initialised.
+    T &operator[](uint32_t id) {
+        if (T *slot = Find(id)) {
+            return *slot;
+        }
+        return Claim(id);
+    }
+
+    // Slots held by this store itself, not counting the base.
+    size_t size() const {
+        return size_;
+    }
+
+    bool empty() const {
+        return size_ == 0;
+    }
+
+    // Drops this store's own slots; the base stays attached.
+    void clear() {
+        pages_.clear();
+        size_ = 0;
+    }
+
+    // Calls fn(id, value) for every slot this store holds in ascending id order, then likewise
+    // for each base in turn, skipping ids shadowed by a store above it.
+    template <typename Fn>
+    void ForEach(Fn &&fn) const {
+        for (const ShareStore *layer = this; layer != nullptr; layer = layer->base_.get()) {
+            layer->ForEachOwn([&](uint32_t id, const T &value) {
+                for (const ShareStore *above = this; above != layer; above = above->base_.get()) {
+                    if (above->FindOwn(id) != nullptr) {
+                        return;
+                    }
+                }
+                fn(id, value);
+            });
+        }
+    }
+
+  private:
+    struct Page {
+        bool Present(uint32_t slot) const {
+            return (present[slot / 64] >> (slot % 64)) & 1;
+        }
+
+        std::array<uint64_t, kPageSize / 64> present{};
+        T slots[kPageSize]{};
+    };
+
+    T *FindOwn(uint32_t id) const {
+        Page *page = PageOf(id);
+        const uint32_t slot = id & (kPageSize - 1);
+        return page != nullptr && page->Present(slot) ? &page->slots[slot] : nullptr;
+    }
+
+    // Marks an absent slot present. It still holds its value-initialised contents: slots only
+    // become absent again by dropping their whole page.
+    T &Claim(uint32_t id) {
+        const uint32_t page_index = id >> kPageBits;
+        if (page_index >= pages_.size()) {
+            pages_.resize(page_index + 1);
+        }
+        std::unique_ptr<Page> &page = pages_[page_index];
+        if (!page) {
+            page = std::make_unique<Page>();
+        }
+        const uint32_t slot = id & (kPageSize - 1);
+        page->present[slot / 64] |= uint64_t{1} << (slot % 64);
+        ++size_;
+        return page->slots[slot];
+    }
+
+    template <typename Fn>
+    void ForEachOwn(Fn &&fn) const {
+        for (size_t page_index = 0; page_index < pages_.size(); ++page_index) {
+            const Page *page = pages_[page_index].get();
+            if (page == nullptr) {
+                continue;
+            }
+            const uint32_t base = static_cast<uint32_t>(page_index) << kPageBits;
+            for (uint32_t word = 0; word < kPageSize / 64; ++word) {
+                for (uint64_t bits = page->present[word]; bits != 0; bits &= bits - 1) {
+                    const uint32_t slot = word * 64 + std::countr_zero(bits);
+                    fn(base + slot, page->slots[slot]);
+                }
+            }
+        }
+    }
+
+    Page *PageOf(uint32_t id) const {
+        const uint32_t page_index = id >> kPageBits;
+        return page_index < pages_.size() ? pages_[page_index].get() : nullptr;
+    }
+
+    std::shared_ptr<const ShareStore> base_;
+    std::vector<std::unique_ptr<Page>> pages_;
+    size_t size_ = 0;
+};
+
+#endif  // SHARESTORE_H
@@ -4,6 +4,7 @@
 #include <cstdint>
 #include <vector>
 
+#include "Coroutine.h"
 #include "NetworkNode.h"
 #include "PCNode.h"
 
@@ -27,6 +28,10 @@ class JointSharingBetaProtocol {
   public:
     static void Handle(const std::vector<uint8_t> &data, Node &node, NetworkNode &network_node,
                        const TaskContext &ctx);
+
+    // Coroutine variant of Handle().
+    static ProtocolTask<> HandleAsync(std::vector<uint8_t> data, Node &node,
+                                      NetworkNode &network_node, TaskContext ctx);
 };
 
 class JointSharingOfflineProtocol {
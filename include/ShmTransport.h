@@ -0,0 +1,67 @@
+#ifndef SHMTRANSPORT_H
+#define SHMTRANSPORT_H
+
+#include <array>
+#include <atomic>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "Transport.h"
+
+// Transport for parties on the same host. Every node owns a POSIX shared-memory inbox
+// ("shm://name" maps to /dev/shm/name) holding one single-producer/single-consumer byte ring
+// per sender. A batch is written as a u64 length followed by its bytes; batches larger than
+// the ring are streamed through it in pieces. Both sides only use atomic head/tail counters,
+// no locks and no syscalls on the data path. A node that restarts retires the inbox of its
+// previous run, and its peers switch to the new one.
+class ShmTransport : public Transport {
+  public:
+    static constexpr size_t kDefaultRingBytes = 4 << 20;
+
+    ShmTransport(int node_id, const std::unordered_map<int, std::string> &addresses,
+                 size_t ring_bytes = kDefaultRingBytes);
+    ~ShmTransport() override;
+
+    ShmTransport(const ShmTransport &) = delete;
+    ShmTransport &operator=(const ShmTransport &) = delete;
+
+    void Send(int peer_id, PooledBuffer *batch) override;
+
+    bool Poll(std::chrono::milliseconds timeout, const BatchHandler &on_batch) override;
+
+    void Interrupt() override;
+
+  private:
+    struct Ring;
+    struct Segment;
+
+    // Partially received batch from one sender.
+    struct InboundState {
+        std::vector<uint8_t> batch;
+        size_t expected = 0;
+        bool has_length = false;
+    };
+
+    static Segment *Map(const std::string &name, size_t ring_bytes, bool create);
+
+    // Maps the peer's inbox on first use; null only if interrupted before the peer appeared.
+    Segment *PeerSegment(int peer_id);
+
+    // Writes one batch into our ring of `peer`. Returns false if the peer retired the segment
+    // before the batch was fully published; true once it is, or the transport is interrupted.
+    bool Write(Segment &peer, const PooledBuffer &batch);
+
+    bool ReadReady(int sender_id, const BatchHandler &on_batch);
+
+    int node_id_;
+    size_t ring_bytes_;
+    std::string inbox_name_;
+    Segment *inbox_ = nullptr;
+    std::unordered_map<int, std::string> peer_names_;
+    std::array<Segment *, 6> peers_{};
+    std::array<InboundState, 6> inbound_;
+    std::atomic<bool> interrupted_{false};
+};
+
+#endif  // SHMTRANSPORT_H
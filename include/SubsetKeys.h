@@ -0,0 +1,71 @@
+#ifndef SUBSETKEYS_H
+#define SUBSETKEYS_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include "Prf.h"
+
+// Set of parties as a bitmask, bit id - 1 for party id.
+using PartySet = uint8_t;
+
+constexpr PartySet kAllParties = 0x1f;
+
+constexpr PartySet PartyBit(const uint8_t id) {
+    return static_cast<PartySet>(1u << (id - 1));
+}
+
+constexpr PartySet AllPartiesExcept(const uint8_t id) {
+    return kAllParties & ~PartyBit(id);
+}
+
+// What offline randomness is drawn for. Each domain owns the counters whose top byte is its
+// value, so protocols never reuse each other's PRF inputs.
+enum class RandomDomain : uint8_t {
+    kSharing = 1,
+    kJointSharingBeta,
+    kJointSharing,
+    kMul,
+    kTruncation,
+    kReSharing,
+};
+
+constexpr size_t kRandomDomainCount = 7;
+
+constexpr uint64_t RandomCounter(const RandomDomain domain, const uint64_t index) {
+    return static_cast<uint64_t>(domain) << 56 | index;
+}
+
+// One PRF key per party subset: values drawn under the key of a subset are known to exactly its
+// members, which is how the offline protocols hand correlated randomness to the parties that may
+// see it without sending anything. Streams are AES-CTR with a per-session nonce, so sessions with
+// distinct nonces can share one key set and run in parallel.
+class SubsetKeys {
+  public:
+    static constexpr size_t kSubsetCount = 32;
+
+    // Keys for every subset derived from one master key, the same at every party. Offers no
+    // privacy between parties; for tests and benchmarks that skip the key-setup phase.
+    static std::shared_ptr<const SubsetKeys> Derive(const uint8_t *master_key);
+
+    // Derive() of the fixed all-ones key, built once and shared by default-constructed Nodes.
+    static const std::shared_ptr<const SubsetKeys> &Default();
+
+    void SetKey(PartySet subset, const uint8_t *key);
+
+    bool Has(const PartySet subset) const {
+        return (present_ >> subset) & 1;
+    }
+
+    // out[i] = PRF_subset(nonce, first_counter + i); throws if this set lacks the subset's key.
+    void Generate(PartySet subset, uint64_t nonce, uint64_t first_counter, size_t count,
+                  uint64_t *out) const;
+
+  private:
+    uint32_t present_ = 0;
+    std::array<Prf, kSubsetCount> prfs_{};
+};
+
+#endif  // SUBSETKEYS_H
@@ -0,0 +1,46 @@
+#ifndef TRANSPORT_H
+#define TRANSPORT_H
+
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+#include "BufferPool.h"
+
+using BatchHandler = std::function<void(const void *data, size_t size)>;
+
+// Moves encoded batches between parties. NetworkNode owns one transport; Send() for a given
+// peer is only ever called from the sender thread that owns that peer, and Poll()/Interrupt()
+// from the receiver thread and Stop() respectively.
+class Transport {
+  public:
+    virtual ~Transport() = default;
+
+    // Ships one batch to peer_id. The transport owns `batch` from here on and returns it to its
+    // pool once the bytes are no longer needed.
+    virtual void Send(int peer_id, PooledBuffer *batch) = 0;
+
+    // Waits up to `timeout` (negative: until a batch arrives or Interrupt()) and hands every
+    // batch that is ready to `on_batch`. Returns false if nothing arrived.
+    virtual bool Poll(std::chrono::milliseconds timeout, const BatchHandler &on_batch) = 0;
+
+    // Wakes a blocked Poll(); called once when the node stops.
+    virtual void Interrupt() = 0;
+
+    // Blocks until every batch passed to Send() has left this transport, so that stopping the
+    // node cannot drop it. Transports that send synchronously have nothing to wait for.
+    virtual void WaitSent() {}
+};
+
+// Picks the transport from the address scheme: "shm://name" addresses use shared-memory rings,
+// anything else (tcp://, ipc://, inproc://) goes through ZeroMQ.
+std::unique_ptr<Transport> MakeTransport(int node_id, int io_threads,
+                                         const std::unordered_map<int, std::string> &addresses);
+
+// Address sets for five co-located parties: "tcp", "ipc", "inproc" or "shm".
+std::unordered_map<int, std::string> LocalNodeAddresses(const std::string &scheme);
+
+#endif  // TRANSPORT_H
@@ -4,6 +4,7 @@
 #include <cstdint>
 #include <vector>
 
+#include "Coroutine.h"
 #include "NetworkNode.h"
 #include "PCNode.h"
 
@@ -29,6 +30,12 @@ class TrunOnProtocol {
   public:
     static void Handle(const std::vector<uint8_t> &data, Node &node, NetworkNode &network_node,
                        TaskContext &ctx);
+
+    // Coroutine variant of Handle(). Advances ctx like Handle(); ctx is held by reference until
+    // the task finishes, so it must outlive the awaited task (not a temporary or a local of a
+    // frame that returns before the task is awaited).
+    static ProtocolTask<> HandleAsync(std::vector<uint8_t> data, Node &node,
+                                      NetworkNode &network_node, TaskContext &ctx);
 };
 
 class TrunOnPrepareProtocol {
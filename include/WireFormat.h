@@ -0,0 +1,132 @@
+#ifndef WIREFORMAT_H
+#define WIREFORMAT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+// Binary batch layout (all fields little-endian):
+//   batch  := sender_id:u32 frame*
+//   frame  := task_id:u32 operation_id:u32 count:u32 value:u64[count]
+//           | task_id:u32 operation_id:u32 (count | kBitFrameFlag):u32 bits:u8[(count + 7) / 8]
+// Bit frames carry boolean shares, value i being bit i % 8 of byte i / 8.
+constexpr size_t kBatchHeaderSize = 4;
+constexpr size_t kFrameHeaderSize = 12;
+constexpr uint32_t kBitFrameFlag = 0x80000000u;
+
+inline void StoreLE32(uint8_t *dst, const uint32_t value) {
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    const uint32_t le = __builtin_bswap32(value);
+#else
+    const uint32_t le = value;
+#endif
+    std::memcpy(dst, &le, sizeof(le));
+}
+
+inline void StoreLE64(uint8_t *dst, const uint64_t value) {
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    const uint64_t le = __builtin_bswap64(value);
+#else
+    const uint64_t le = value;
+#endif
+    std::memcpy(dst, &le, sizeof(le));
+}
+
+inline uint32_t LoadLE32(const uint8_t *src) {
+    uint32_t le;
+    std::memcpy(&le, src, sizeof(le));
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    return __builtin_bswap32(le);
+#else
+    return le;
+#endif
+}
+
+inline uint64_t LoadLE64(const uint8_t *src) {
+    uint64_t le;
+    std::memcpy(&le, src, sizeof(le));
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    return __builtin_bswap64(le);
+#else
+    return le;
+#endif
+}
+
+struct FrameView {
+    int task_id;
+    int operation_id;
+    uint32_t count;
+    bool bits;
+    const uint8_t *values;
+
+    uint64_t Value(const size_t index) const {
+        if (bits) {
+            return (values[index / 8] >> (index % 8)) & 1U;
+        }
+        return LoadLE64(values + index * sizeof(uint64_t));
+    }
+};
+
+// Appends frames to a reusable buffer. Consecutive values for the same (task, operation)
+// are coalesced into a single frame.
+class FrameWriter {
+  public:
+    void Reset(int sender_id);
+
+    void Append(int task_id, int operation_id, uint64_t value);
+
+    void Append(int task_id, int operation_id, const uint64_t *values, size_t count);
+
+    // Appends boolean shares (only the lowest bit of each value is kept) to a bit frame.
+    void AppendBits(int task_id, int operation_id, const uint64_t *bits, size_t count);
+
+    bool Empty() const {
+        return buffer_.size() <= kBatchHeaderSize;
+    }
+
+    const std::vector<uint8_t> &Buffer() const {
+        return buffer_;
+    }
+
+    // Hands the encoded batch to `other` and keeps other's storage for the next Reset(), so a
+    // pooled buffer can be shipped without copying the bytes.
+    void SwapBuffer(std::vector<uint8_t> &other) {
+        buffer_.swap(other);
+        last_frame_ = 0;
+    }
+
+  private:
+    uint8_t *OpenFrame(int task_id, int operation_id, size_t count);
+
+    std::vector<uint8_t> buffer_;
+    size_t last_frame_ = 0;
+    int last_task_id_ = 0;
+    int last_operation_id_ = 0;
+    bool last_frame_bits_ = false;
+};
+
+// Walks the frames of a received batch in place, without copying the payload.
+class FrameReader {
+  public:
+    FrameReader(const void *data, size_t size);
+
+    int SenderID() const {
+        return sender_id_;
+    }
+
+    bool Valid() const {
+        return valid_;
+    }
+
+    bool Next(FrameView &frame);
+
+  private:
+    const uint8_t *data_;
+    size_t size_;
+    size_t pos_ = kBatchHeaderSize;
+    int sender_id_ = 0;
+    bool valid_ = false;
+};
+
+#endif  // WIREFORMAT_H
@@ -0,0 +1,38 @@
+#ifndef ZMQTRANSPORT_H
+#define ZMQTRANSPORT_H
+
+#include <string>
+#include <unordered_map>
+#include <zmq.hpp>
+
+#include "Transport.h"
+
+// ROUTER socket for inbound batches and one DEALER per peer. Works with tcp://, ipc:// and
+// inproc:// endpoints; inproc endpoints only connect within one context, so all inproc
+// transports in a process share SharedContext().
+class ZmqTransport : public Transport {
+  public:
+    ZmqTransport(int node_id, int io_threads,
+                 const std::unordered_map<int, std::string> &addresses);
+
+    void Send(int peer_id, PooledBuffer *batch) override;
+
+    bool Poll(std::chrono::milliseconds timeout, const BatchHandler &on_batch) override;
+
+    void Interrupt() override;
+
+    static zmq::context_t &SharedContext();
+
+  private:
+    int node_id_;
+    std::unique_ptr<zmq::context_t> own_context_;
+    zmq::context_t &context_;
+    zmq::socket_t router_;
+    zmq::socket_t exit_pair_;
+    std::string exit_address_;
+    std::unordered_map<int, zmq::socket_t> dealers_;
+    zmq::message_t identity_;
+    zmq::message_t message_;
+};
+
+#endif  // ZMQTRANSPORT_H
@@ -8,7 +8,11 @@ for port in {5550..5560}; do
         kill -9 $pid
     fi
 done
-sleep 5
+# Wait for the killed processes to let go of the ports; the nodes line themselves up with
+# WaitForPeers(), so no fixed delay is needed.
+while lsof -ti :5550-5560 >/dev/null; do
+    sleep 0.1
+done
 
 for i in {1..5}; do
     echo "Starting Node $i..."
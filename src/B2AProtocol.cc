@@ -6,6 +6,7 @@
 
 void B2AOffProtocol::Handle(const std::vector<uint8_t>& data, Node& node, NetworkNode& network_node,
                             TaskContext& ctx) {
+    const TrafficClassScope bulk(TrafficClass::kBulk);
     uint16_t idx = bytesToUint16(data[1], data[2]);
     uint16_t start_id = bytesToUint16(data[3], data[4]);
     const CipherData& beta_share = node.BetaShares(idx);
@@ -0,0 +1,71 @@
+#include "CipherVector.h"
+
+#include <algorithm>
+#include <cstring>
+
+CipherVector::CipherVector(const size_t size)
+    : size_(size),
+      stride_((size + kAlignment / sizeof(uint64_t) - 1) & ~(kAlignment / sizeof(uint64_t) - 1)),
+      data_(static_cast<uint64_t *>(
+          ::operator new[](std::max<size_t>(6 * stride_, 1) * sizeof(uint64_t),
+                           std::align_val_t{kAlignment}))) {
+    std::memset(data_.get(), 0, 6 * stride_ * sizeof(uint64_t));
+}
+
+CipherVector CipherVector::Load(const Node &node, const uint32_t start_id, const size_t count) {
+    CipherVector vector(count);
+    for (size_t i = 0; i < count; ++i) {
+        vector.Set(i, node.BetaShares(start_id + i));
+    }
+    return vector;
+}
+
+void CipherVector::Store(Node &node, const uint32_t start_id) const {
+    for (size_t i = 0; i < size_; ++i) {
+        node.SetBetaShares(start_id + i, Get(i));
+    }
+}
+
+CipherData CipherVector::Get(const size_t i) const {
+    CipherData cipher{};
+    for (size_t index = 1; index <= 5; ++index) {
+        cipher.SetAlpha(Alpha(index)[i], index);
+    }
+    cipher.SetBeta(Beta()[i]);
+    return cipher;
+}
+
+void CipherVector::Set(const size_t i, const CipherData &cipher) {
+    for (size_t index = 1; index <= 5; ++index) {
+        Alpha(index)[i] = cipher.Alpha(index);
+    }
+    Beta()[i] = cipher.Beta();
+}
+
+// 64-bit lane multiplies only pay off with AVX2; the baseline x86-64 clone stays scalar-speed.
+__attribute__((target_clones("avx2", "default"))) void ColumnDots(const uint64_t *column,
+                                                                 const CipherVector &vector,
+                                                                 uint64_t (&sums)[6]) {
+    const uint64_t *__restrict a = column;
+    const uint64_t *__restrict b1 = vector.Alpha(1);
+    const uint64_t *__restrict b2 = vector.Alpha(2);
+    const uint64_t *__restrict b3 = vector.Alpha(3);
+    const uint64_t *__restrict b4 = vector.Alpha(4);
+    const uint64_t *__restrict b5 = vector.Alpha(5);
+    const uint64_t *__restrict beta = vector.Beta();
+    uint64_t s1 = 0, s2 = 0, s3 = 0, s4 = 0, s5 = 0, s6 = 0;
+    for (size_t i = 0; i < vector.size(); ++i) {
+        s1 += a[i] * b1[i];
+        s2 += a[i] * b2[i];
+        s3 += a[i] * b3[i];
+        s4 += a[i] * b4[i];
+        s5 += a[i] * b5[i];
+        s6 += a[i] * beta[i];
+    }
+    sums[0] = s1;
+    sums[1] = s2;
+    sums[2] = s3;
+    sums[3] = s4;
+    sums[4] = s5;
+    sums[5] = s6;
+}
@@ -0,0 +1,138 @@
+#include "Coroutine.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace {
+
+thread_local Scheduler *current_scheduler = nullptr;
+
+}  // namespace
+
+Scheduler::Scheduler(int threads) {
+    for (int i = 0; i < std::max(1, threads); i++) {
+        workers_.emplace_back(&Scheduler::WorkerLoop, this);
+    }
+}
+
+Scheduler::~Scheduler() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    cv_.notify_all();
+    for (auto &worker : workers_) {
+        worker.join();
+    }
+}
+
+Scheduler *Scheduler::Current() {
+    return current_scheduler;
+}
+
+void Scheduler::Post(std::coroutine_handle<> handle) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        ready_.push_back(handle);
+    }
+    cv_.notify_one();
+}
+
+void Scheduler::Spawn(ProtocolTask<> task) {
+    {
+        std::lock_guard<std::mutex> lock(idle_mutex_);
+        ++live_tasks_;
+    }
+    RunDetached(std::move(task));
+}
+
+coroutine_detail::Detached Scheduler::RunDetached(ProtocolTask<> task) {
+    co_await Schedule();
+    std::exception_ptr error;
+    try {
+        co_await task;
+    } catch (...) {
+        error = std::current_exception();
+    }
+    std::lock_guard<std::mutex> lock(idle_mutex_);
+    if (error && !first_error_) {
+        first_error_ = error;
+    }
+    if (--live_tasks_ == 0) {
+        idle_cv_.notify_all();
+    }
+}
+
+void Scheduler::WaitIdle() {
+    std::unique_lock<std::mutex> lock(idle_mutex_);
+    idle_cv_.wait(lock, [this] { return live_tasks_ == 0; });
+    if (first_error_) {
+        std::rethrow_exception(std::exchange(first_error_, nullptr));
+    }
+}
+
+void Scheduler::WorkerLoop() {
+    current_scheduler = this;
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        cv_.wait(lock, [this] { return stopping_ || !ready_.empty(); });
+        if (ready_.empty()) {
+            break;
+        }
+        const std::coroutine_handle<> handle = ready_.front();
+        ready_.pop_front();
+        lock.unlock();
+        handle.resume();
+        lock.lock();
+    }
+}
+
+bool ReceiveAwaiter::await_suspend(std::coroutine_handle<> handle) {
+    scheduler_ = Scheduler::Current();
+    if (scheduler_ == nullptr) {
+        throw std::logic_error("CoReceive awaited outside a Scheduler worker");
+    }
+    handle_ = handle;
+
+    // Shared by the copies std::function makes of the continuation; the last one to go tells a
+    // dropped continuation from one that ran.
+    struct Resumer {
+        explicit Resumer(ReceiveAwaiter *target) : awaiter(target) {}
+        Resumer(const Resumer &) = delete;
+        ~Resumer() {
+            if (!fired) {
+                awaiter->stopped_ = true;
+                awaiter->Arrive();
+            }
+        }
+        ReceiveAwaiter *awaiter;
+        bool fired = false;
+    };
+    auto resumer = std::make_shared<Resumer>(this);
+    auto done = [resumer](uint64_t value) {
+        resumer->fired = true;
+        resumer->awaiter->value_ = value;
+        resumer->awaiter->Arrive();
+    };
+    if (senders_) {
+        network_node_.ReceiveJmpAsync(task_id_, operation_id_, *senders_, std::move(done));
+    } else {
+        network_node_.ReceiveAsync(task_id_, operation_id_, peer_count_, std::move(done));
+    }
+    resumer.reset();
+    // Already delivered: carry on without a round trip through the scheduler.
+    return !arrived_.exchange(true, std::memory_order_acq_rel);
+}
+
+void ReceiveAwaiter::Arrive() {
+    if (arrived_.exchange(true, std::memory_order_acq_rel)) {
+        scheduler_->Post(handle_);
+    }
+}
+
+uint64_t ReceiveAwaiter::await_resume() const {
+    if (stopped_) {
+        throw std::runtime_error("Node is stopping");
+    }
+    return value_;
+}
@@ -1,11 +1,13 @@
 #include <numeric>
 
+#include "CipherVector.h"
 #include "DotProductProtocol.h"
 #include "MulProtocol.h"
 #include "Util.h"
 
 void DotProductOffProtocol::Handle(const std::vector<uint8_t>& data, Node& node,
                                    NetworkNode& network_node, const TaskContext& ctx) {
+    const TrafficClassScope bulk(TrafficClass::kBulk);
     HandleImpl<DefaultCalculator>(data, node, network_node, ctx);
 }
 
@@ -14,75 +16,49 @@ void DotProductOffProtocol::HandleImpl(const std::vector<uint8_t>& data, Node& n
                                        NetworkNode& network_node, const TaskContext& ctx) {
     const uint8_t node_id = node.ID();
     Matrix& matrix = node.MatrixRef();
-    std::vector<CipherData> cipher_x_vec;
-    std::vector<CipherData> cipher_y_vec;
 
     const uint32_t dimension = readUint32(data, 1);
     const uint32_t x_start_idx = readUint32(data, 5);
     const uint32_t y_start_idx = readUint32(data, 9);
 
-    cipher_x_vec.reserve(dimension);
-    for (uint32_t t = 0; t < dimension; t++) {
-        cipher_x_vec.push_back(node.BetaShares(x_start_idx + t));
-    }
-    cipher_y_vec.reserve(dimension);
-    for (uint32_t t = 0; t < dimension; t++) {
-        cipher_y_vec.push_back(node.BetaShares(y_start_idx + t));
-    }
+    const CipherVector cipher_x = CipherVector::Load(node, x_start_idx, dimension);
+    const CipherVector cipher_y = CipherVector::Load(node, y_start_idx, dimension);
 
-    // For each dimension, compute partial products
-    for (uint32_t t = 0; t < dimension; t++) {
-        const CipherData& cipher_x = cipher_x_vec[t];
-        const CipherData& cipher_y = cipher_y_vec[t];
+    // dot[row][col - 1] = sum(alpha_x[row] * alpha_y[col]) over all dimensions, one pass over
+    // the columns per share index this node holds.
+    uint64_t dot[6][6] = {};
+    for (uint32_t row = 1; row <= 5; ++row) {
+        if (row != node_id) {
+            ColumnDots(cipher_x.Alpha(row), cipher_y, dot[row]);
+        }
+    }
+    const auto accumulate = [&](uint32_t row, uint32_t col, uint64_t products) {
+        matrix.Set(row, col, matrix.Get(row, col) + products);
+    };
 
-        for (uint32_t row = 1; row <= 5; ++row) {
-            if (row == node_id) {
-                continue;
-            }
-            for (uint32_t col = 1; col <= 5; ++col) {
-                if (col != node_id && col != row) {
-                    // Accumulate products for each dimension
-                    const uint64_t current = matrix.Get(row, col);
-                    matrix.Set(row, col, current + cipher_x.Alpha(row) * cipher_y.Alpha(col));
-                }
+    for (uint32_t row = 1; row <= 5; ++row) {
+        if (row == node_id) {
+            continue;
+        }
+        for (uint32_t col = 1; col <= 5; ++col) {
+            if (col != node_id && col != row) {
+                accumulate(row, col, dot[row][col - 1]);
             }
         }
+    }
 
-        // Special cases handling for each node's responsibility
-        if (node_id == 1 || node_id == 2) {
-            const uint64_t alpha45 = matrix.Get(4, 5);
-            const uint64_t alpha45_n = alpha45 + cipher_x.Alpha(4) * cipher_y.Alpha(4) +
-                                       cipher_x.Alpha(5) * cipher_y.Alpha(5);
-            matrix.Set(4, 5, alpha45_n);
-
-            const uint64_t alpha35 = matrix.Get(3, 5);
-            const uint64_t alpha35_n = alpha35 + cipher_x.Alpha(3) * cipher_y.Alpha(3);
-            matrix.Set(3, 5, alpha35_n);
-        } else if (node_id == 3) {
-            const uint64_t alpha45 = matrix.Get(4, 5);
-            const uint64_t alpha45_n = alpha45 + cipher_x.Alpha(4) * cipher_y.Alpha(4) +
-                                       cipher_x.Alpha(5) * cipher_y.Alpha(5);
-            matrix.Set(4, 5, alpha45_n);
-
-            const uint64_t alpha12 = matrix.Get(1, 2);
-            const uint64_t alpha12_n = alpha12 + cipher_x.Alpha(1) * cipher_y.Alpha(1) +
-                                       cipher_x.Alpha(2) * cipher_y.Alpha(2);
-            matrix.Set(1, 2, alpha12_n);
-        } else if (node_id == 4) {
-            const uint64_t alpha12 = matrix.Get(1, 2);
-            const uint64_t alpha12_n = alpha12 + cipher_x.Alpha(1) * cipher_y.Alpha(1) +
-                                       cipher_x.Alpha(2) * cipher_y.Alpha(2);
-            matrix.Set(1, 2, alpha12_n);
-
-            const uint64_t alpha35 = matrix.Get(3, 5);
-            const uint64_t alpha35_n = alpha35 + cipher_x.Alpha(3) * cipher_y.Alpha(3);
-            matrix.Set(3, 5, alpha35_n);
-        } else if (node_id == 5) {
-            const uint64_t alpha12 = matrix.Get(1, 2);
-            const uint64_t alpha12_n = alpha12 + cipher_x.Alpha(1) * cipher_y.Alpha(1) +
-                                       cipher_x.Alpha(2) * cipher_y.Alpha(2);
-            matrix.Set(1, 2, alpha12_n);
-        }
+    // Special cases handling for each node's responsibility
+    if (node_id == 1 || node_id == 2) {
+        accumulate(4, 5, dot[4][3] + dot[5][4]);
+        accumulate(3, 5, dot[3][2]);
+    } else if (node_id == 3) {
+        accumulate(4, 5, dot[4][3] + dot[5][4]);
+        accumulate(1, 2, dot[1][0] + dot[2][1]);
+    } else if (node_id == 4) {
+        accumulate(1, 2, dot[1][0] + dot[2][1]);
+        accumulate(3, 5, dot[3][2]);
+    } else if (node_id == 5) {
+        accumulate(1, 2, dot[1][0] + dot[2][1]);
     }
 
     // Continue with joint sharing protocols
@@ -93,44 +69,26 @@ void DotProductOffProtocol::HandleImpl(const std::vector<uint8_t>& data, Node& n
 void DotProductOnProtocol::Handle(const std::vector<uint8_t>& data, Node& node,
                                   NetworkNode& network_node, const TaskContext& ctx) {
     const uint8_t node_id = node.ID();
-    std::vector<CipherData> cipher_x_vec;
-    std::vector<CipherData> cipher_y_vec;
-
     const uint32_t dimension = readUint32(data, 1);
     const uint32_t x_start_idx = readUint32(data, 5);
     const uint32_t y_start_idx = readUint32(data, 9);
     const uint32_t z_idx = readUint32(data, 13);
 
-    cipher_x_vec.reserve(dimension);
-    for (uint32_t t = 0; t < dimension; t++) {
-        cipher_x_vec.push_back(node.BetaShares(x_start_idx + t));
-    }
-    cipher_y_vec.reserve(dimension);
-    for (uint32_t t = 0; t < dimension; t++) {
-        cipher_y_vec.push_back(node.BetaShares(y_start_idx + t));
-    }
+    const CipherVector cipher_x = CipherVector::Load(node, x_start_idx, dimension);
+    const CipherVector cipher_y = CipherVector::Load(node, y_start_idx, dimension);
     CipherData& cipher_z = node.BetaShares(z_idx);
 
+    // beta_x against every column of y and beta_y against every column of x.
+    uint64_t beta_x_dots[6];
+    uint64_t beta_y_dots[6];
+    ColumnDots(cipher_x.Beta(), cipher_y, beta_x_dots);
+    ColumnDots(cipher_y.Beta(), cipher_x, beta_y_dots);
+
     uint64_t beta_z[5] = {};
-    // Compute for all dimensions
-    for (uint32_t t = 0; t < dimension; t++) {
-        const CipherData& cipher_x = cipher_x_vec[t];
-        const CipherData& cipher_y = cipher_y_vec[t];
-        const uint64_t beta_x = cipher_x.Beta();
-        const uint64_t beta_y = cipher_y.Beta();
-
-        for (uint8_t id = 1; id <= 5; ++id) {
-            if (id != node_id) {
-                beta_z[id - 1] += -beta_x * cipher_y.Alpha(id) - beta_y * cipher_x.Alpha(id);
-            }
-        }
-        if (t == 0) {
-            for (uint8_t id = 1; id <= 5; ++id) {
-                if (id != node_id) {
-                    beta_z[id - 1] += cipher_z.Alpha(id);
-                    beta_z[id - 1] += node.AlphaXY(id);
-                }
-            }
+    for (uint8_t id = 1; id <= 5; ++id) {
+        if (id != node_id && dimension > 0) {
+            beta_z[id - 1] = -beta_x_dots[id - 1] - beta_y_dots[id - 1] + cipher_z.Alpha(id) +
+                             node.AlphaXY(id);
         }
     }
 
@@ -151,10 +109,7 @@ void DotProductOnProtocol::Handle(const std::vector<uint8_t>& data, Node& node,
     uint64_t receive_beta = network_node.Receive(ctx.task_id, ctx.operation_id + node_id - 1, 3);
     beta_z[node_id - 1] = receive_beta;
 
-    uint64_t beta_dot_product = 0;
-    for (uint32_t t = 0; t < dimension; t++) {
-        beta_dot_product += cipher_x_vec[t].Beta() * cipher_y_vec[t].Beta();
-    }
+    const uint64_t beta_dot_product = beta_x_dots[5];
 
     const uint64_t sum =
         std::accumulate(std::begin(beta_z), std::end(beta_z), static_cast<uint64_t>(0));
@@ -7,11 +7,24 @@ uint64_t JMPFunc(const uint64_t va, const uint64_t vb, const uint64_t vc) {
 void JMPProtocol::Handle(const std::vector<uint8_t> &data, Node &node, NetworkNode &network_node,
                          const TaskContext &ctx) {
     const uint8_t node_id = node.ID();
+    const JmpSenders senders = {data[1], data[2], data[3]};
 
     if (node_id == data[1] || node_id == data[2] || node_id == data[3]) {
-        network_node.AddMessage(data[4], ctx.task_id, ctx.operation_id, node.T());
+        network_node.SendJmp(data[4], ctx.task_id, ctx.operation_id, node.T(), senders);
     } else if (node_id == data[4]) {
-        uint64_t t = network_node.Receive(ctx.task_id, ctx.operation_id, 3);
+        uint64_t t = network_node.ReceiveJmp(ctx.task_id, ctx.operation_id, senders);
         node.SetT(t);
     }
 }
+
+ProtocolTask<> JMPProtocol::HandleAsync(std::vector<uint8_t> data, Node &node,
+                                        NetworkNode &network_node, TaskContext ctx) {
+    const uint8_t node_id = node.ID();
+    const JmpSenders senders = {data[1], data[2], data[3]};
+
+    if (node_id == data[1] || node_id == data[2] || node_id == data[3]) {
+        network_node.SendJmp(data[4], ctx.task_id, ctx.operation_id, node.T(), senders);
+    } else if (node_id == data[4]) {
+        node.SetT(co_await CoReceiveJmp(network_node, ctx.task_id, ctx.operation_id, senders));
+    }
+}
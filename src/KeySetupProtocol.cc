@@ -0,0 +1,47 @@
+#include "KeySetupProtocol.h"
+
+#include <bit>
+#include <cstring>
+#include <random>
+
+std::shared_ptr<const SubsetKeys> KeySetupProtocol::Handle(Node &node, NetworkNode &network_node,
+                                                           const TaskContext &ctx) {
+    const uint8_t node_id = node.ID();
+    auto keys = std::make_shared<SubsetKeys>();
+    std::random_device rd;
+
+    // Send every key this party samples before waiting on any, so no two leaders block each
+    // other.
+    for (PartySet subset = 1; subset <= kAllParties; ++subset) {
+        if (std::countr_zero(subset) + 1 != node_id) {
+            continue;
+        }
+        uint64_t words[2];
+        for (uint64_t &word : words) {
+            word = static_cast<uint64_t>(rd()) << 32 | rd();
+        }
+        for (uint8_t member = node_id + 1; member <= 5; ++member) {
+            if (subset & PartyBit(member)) {
+                network_node.AddMessages(member, ctx.task_id, ctx.operation_id + subset - 1,
+                                         words);
+            }
+        }
+        uint8_t key[Prf::kKeySize];
+        std::memcpy(key, words, sizeof(key));
+        keys->SetKey(subset, key);
+    }
+
+    for (PartySet subset = 1; subset <= kAllParties; ++subset) {
+        if (!(subset & PartyBit(node_id)) || std::countr_zero(subset) + 1 == node_id) {
+            continue;
+        }
+        uint64_t words[2];
+        network_node.ReceiveVector(ctx.task_id, ctx.operation_id + subset - 1, words, 1);
+        uint8_t key[Prf::kKeySize];
+        std::memcpy(key, words, sizeof(key));
+        keys->SetKey(subset, key);
+    }
+
+    node.SetSubsetKeys(keys);
+    return keys;
+}
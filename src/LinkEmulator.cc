@@ -0,0 +1,158 @@
+#include "LinkEmulator.h"
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+LinkProfiles LoadLinkProfiles(const std::string &path, int node_id) {
+    std::ifstream file(path);
+    if (!file) {
+        throw std::runtime_error("Cannot open link profile " + path);
+    }
+
+    LinkProfiles profiles{};
+    std::string line;
+    int line_number = 0;
+    while (std::getline(file, line)) {
+        ++line_number;
+        line = line.substr(0, line.find('#'));
+        std::istringstream fields(line);
+        std::string from, to;
+        LinkProfile profile;
+        if (!(fields >> from)) {
+            continue;
+        }
+        if (!(fields >> to >> profile.delay_ms >> profile.jitter_ms >> profile.bandwidth_mbps)) {
+            throw std::runtime_error(path + ":" + std::to_string(line_number) +
+                                     ": expected <from> <to> <delay_ms> <jitter_ms> <mbps>");
+        }
+        fields >> profile.burst_bytes;
+
+        if (from != "*" && std::stoi(from) != node_id) {
+            continue;
+        }
+        for (int peer_id = 1; peer_id <= 5; peer_id++) {
+            if (to == "*" || std::stoi(to) == peer_id) {
+                profiles[peer_id] = profile;
+            }
+        }
+    }
+    return profiles;
+}
+
+LinkEmulator::LinkEmulator(std::unique_ptr<Transport> inner, const LinkProfiles &profiles,
+                           uint64_t seed)
+    : inner_(std::move(inner)), profiles_(profiles), rng_(seed) {
+    const auto now = Clock::now();
+    for (int peer_id = 0; peer_id < static_cast<int>(links_.size()); peer_id++) {
+        links_[peer_id].tokens = static_cast<double>(profiles_[peer_id].burst_bytes);
+        links_[peer_id].refilled = now;
+        links_[peer_id].last_delivery = now;
+    }
+    delivery_ = std::thread(&LinkEmulator::DeliveryLoop, this);
+}
+
+LinkEmulator::~LinkEmulator() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    cv_.notify_all();
+    delivery_.join();
+    while (!pending_.empty()) {
+        PooledBuffer *batch = pending_.top().batch;
+        pending_.pop();
+        BufferPool::Release(batch->bytes.data(), batch);
+    }
+}
+
+LinkEmulator::Clock::time_point LinkEmulator::Schedule(int peer_id, size_t bytes) {
+    const LinkProfile &profile = profiles_.at(peer_id);
+    LinkState &link = links_[peer_id];
+    const auto now = Clock::now();
+
+    // The bucket may go negative: the batch then leaves once the debt has been paid back.
+    auto departure = now;
+    if (profile.bandwidth_mbps > 0) {
+        const double bytes_per_second = profile.bandwidth_mbps * 1e6 / 8;
+        const double elapsed = std::chrono::duration<double>(now - link.refilled).count();
+        link.tokens = std::min(static_cast<double>(profile.burst_bytes),
+                               link.tokens + elapsed * bytes_per_second);
+        link.refilled = now;
+        link.tokens -= static_cast<double>(bytes);
+        if (link.tokens < 0) {
+            departure += std::chrono::duration_cast<Clock::duration>(
+                std::chrono::duration<double>(-link.tokens / bytes_per_second));
+        }
+    }
+
+    double delay_ms = profile.delay_ms;
+    if (profile.jitter_ms > 0) {
+        std::uniform_real_distribution<double> jitter(-profile.jitter_ms, profile.jitter_ms);
+        delay_ms = std::max(0.0, delay_ms + jitter(rng_));
+    }
+    auto delivery = departure + std::chrono::duration_cast<Clock::duration>(
+                                    std::chrono::duration<double, std::milli>(delay_ms));
+    delivery = std::max(delivery, link.last_delivery);
+    link.last_delivery = delivery;
+    return delivery;
+}
+
+void LinkEmulator::Send(int peer_id, PooledBuffer *batch) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (stopping_) {
+            BufferPool::Release(batch->bytes.data(), batch);
+            return;
+        }
+        pending_.push(Pending{Schedule(peer_id, batch->bytes.size()), sequence_++, peer_id, batch});
+    }
+    cv_.notify_one();
+}
+
+void LinkEmulator::DeliveryLoop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!stopping_) {
+        if (pending_.empty()) {
+            cv_.wait(lock);
+            continue;
+        }
+        const Pending next = pending_.top();
+        if (Clock::now() < next.deliver_at) {
+            // A new batch may be due earlier on another link, so wake up on every Send.
+            cv_.wait_until(lock, next.deliver_at);
+            continue;
+        }
+        pending_.pop();
+        delivering_ = true;
+        lock.unlock();
+        inner_->Send(next.peer_id, next.batch);
+        lock.lock();
+        delivering_ = false;
+        if (pending_.empty()) {
+            sent_cv_.notify_all();
+        }
+    }
+    sent_cv_.notify_all();
+}
+
+void LinkEmulator::WaitSent() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    sent_cv_.wait(lock, [this] { return stopping_ || (pending_.empty() && !delivering_); });
+    lock.unlock();
+    inner_->WaitSent();
+}
+
+bool LinkEmulator::Poll(std::chrono::milliseconds timeout, const BatchHandler &on_batch) {
+    return inner_->Poll(timeout, on_batch);
+}
+
+void LinkEmulator::Interrupt() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    cv_.notify_all();
+    inner_->Interrupt();
+}
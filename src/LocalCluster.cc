@@ -0,0 +1,124 @@
+#include "LocalCluster.h"
+
+#include <algorithm>
+#include <future>
+#include <iostream>
+
+#include "KeySetupProtocol.h"
+#include "Timer.h"
+
+namespace {
+
+void AddLastCopies(const NetworkStats &stats, std::array<uint64_t, 6> &totals) {
+    for (int peer_id = 1; peer_id <= 5; peer_id++) {
+        for (const uint64_t count : stats.stragglers[peer_id]) {
+            totals[peer_id] += count;
+        }
+    }
+}
+
+}  // namespace
+
+LocalCluster::LocalCluster(uint32_t share_count, const NetworkOptions &options)
+    : hub_(std::make_shared<MemoryHub>()) {
+    for (int id = 1; id <= 5; id++) {
+        nodes_[id] = std::make_unique<Node>(id, share_count);
+        network_nodes_[id] =
+            std::make_unique<NetworkNode>(id, std::make_unique<MemoryTransport>(id, hub_), options);
+        contexts_[id] = TaskContext{0, 1};
+    }
+    for (int id = 1; id <= 5; id++) {
+        threads_.emplace_back(&NetworkNode::ReceiveMessages, network_nodes_[id].get());
+        threads_.emplace_back(&NetworkNode::SendMessages, network_nodes_[id].get());
+    }
+}
+
+LocalCluster::~LocalCluster() {
+    for (int id = 1; id <= 5; id++) {
+        network_nodes_[id]->Stop();
+    }
+    for (auto &thread : threads_) {
+        thread.join();
+    }
+}
+
+ClusterReport LocalCluster::Run(const std::string &name, const PartyStep &step, int repetitions) {
+    std::array<uint64_t, 6> receive_calls{};
+    std::array<uint64_t, 6> last_copies{};
+    std::array<NetworkStats, 6> before{};
+    for (int id = 1; id <= 5; id++) {
+        before[id] = network_nodes_[id]->Stats();
+        receive_calls[id] = before[id].receive_calls;
+        AddLastCopies(before[id], last_copies);
+    }
+    const uint64_t bytes_before = hub_->BytesSent();
+
+    Timer timer;
+    timer.start();
+    std::vector<std::future<void>> parties;
+    for (int id = 1; id <= 5; id++) {
+        parties.push_back(std::async(std::launch::async, [this, id, &step, repetitions] {
+            try {
+                for (int i = 0; i < repetitions; i++) {
+                    step(*nodes_[id], *network_nodes_[id], contexts_[id]);
+                }
+            } catch (...) {
+                // The other parties would wait forever for this one's messages.
+                for (int peer = 1; peer <= 5; peer++) {
+                    network_nodes_[peer]->Stop();
+                }
+                throw;
+            }
+        }));
+    }
+    for (auto &party : parties) {
+        party.get();
+    }
+    timer.stop();
+
+    ClusterReport report{name, repetitions, timer.elapsedMicroseconds(), 0, 0, {}, 0, {}};
+    for (int id = 1; id <= 5; id++) {
+        const NetworkStats stats = network_nodes_[id]->Stats();
+        report.rounds = std::max(report.rounds, stats.receive_calls - receive_calls[id]);
+        AddLastCopies(stats, report.last_copies);
+        report.dispatchers = stats.dispatchers;
+        for (int i = 0; i < stats.dispatchers; i++) {
+            const uint64_t busy_us =
+                stats.dispatcher_stats[i].busy_us - before[id].dispatcher_stats[i].busy_us;
+            report.dispatcher_load[i] +=
+                static_cast<double>(busy_us) / std::max<long long>(1, report.wall_us) / 5;
+        }
+    }
+    for (int peer_id = 1; peer_id <= 5; peer_id++) {
+        report.last_copies[peer_id] -= last_copies[peer_id];
+    }
+    report.bytes = hub_->BytesSent() - bytes_before;
+    return report;
+}
+
+ClusterReport LocalCluster::SetupKeys() {
+    return Run("KeySetup", [](Node &node, NetworkNode &network_node, TaskContext &ctx) {
+        KeySetupProtocol::Handle(node, network_node, ctx);
+        ctx.operation_id += KeySetupProtocol::kOperationCount;
+    });
+}
+
+void LocalCluster::Print(const ClusterReport &report) {
+    const double reps = report.repetitions;
+    std::cout << report.name << ": " << report.wall_us / reps << " us/op, "
+              << report.rounds / reps << " rounds/op, " << report.bytes / reps << " bytes/op ("
+              << report.repetitions << " ops)" << std::endl;
+    if (std::any_of(report.last_copies.begin(), report.last_copies.end(),
+                    [](uint64_t count) { return count > 0; })) {
+        std::cout << "  last copy by party:";
+        for (int peer_id = 1; peer_id <= 5; peer_id++) {
+            std::cout << " " << peer_id << "=" << report.last_copies[peer_id];
+        }
+        std::cout << std::endl;
+    }
+    std::cout << "  dispatcher load:";
+    for (int i = 0; i < report.dispatchers; i++) {
+        std::cout << " " << i << "=" << static_cast<int>(report.dispatcher_load[i] * 100) << "%";
+    }
+    std::cout << std::endl;
+}
@@ -0,0 +1,46 @@
+#include "MemoryTransport.h"
+
+MemoryTransport::MemoryTransport(int node_id, std::shared_ptr<MemoryHub> hub)
+    : node_id_(node_id), hub_(std::move(hub)) {}
+
+void MemoryTransport::Send(int peer_id, PooledBuffer *batch) {
+    hub_->AddBytes(batch->bytes.size());
+    MemoryHub::Inbox &inbox = hub_->At(peer_id);
+    {
+        std::lock_guard<std::mutex> lock(inbox.mutex);
+        inbox.batches.emplace_back(batch->bytes.begin(), batch->bytes.end());
+    }
+    inbox.cv.notify_one();
+    BufferPool::Release(batch->bytes.data(), batch);
+}
+
+bool MemoryTransport::Poll(std::chrono::milliseconds timeout, const BatchHandler &on_batch) {
+    MemoryHub::Inbox &inbox = hub_->At(node_id_);
+    {
+        std::unique_lock<std::mutex> lock(inbox.mutex);
+        const auto ready = [&] { return inbox.interrupted || !inbox.batches.empty(); };
+        if (timeout.count() < 0) {
+            inbox.cv.wait(lock, ready);
+        } else if (timeout.count() > 0) {
+            inbox.cv.wait_for(lock, timeout, ready);
+        }
+        // Take everything at once and dispatch without holding the mailbox lock.
+        ready_.swap(inbox.batches);
+    }
+
+    const bool received = !ready_.empty();
+    for (const auto &batch : ready_) {
+        on_batch(batch.data(), batch.size());
+    }
+    ready_.clear();
+    return received;
+}
+
+void MemoryTransport::Interrupt() {
+    MemoryHub::Inbox &inbox = hub_->At(node_id_);
+    {
+        std::lock_guard<std::mutex> lock(inbox.mutex);
+        inbox.interrupted = true;
+    }
+    inbox.cv.notify_all();
+}
@@ -6,6 +6,7 @@
 
 void MulOffProtocol::Handle(const std::vector<uint8_t>& data, Node& node, NetworkNode& network_node,
                             const TaskContext& ctx) {
+    const TrafficClassScope bulk(TrafficClass::kBulk);
     switch (data[0]) {
         case ProtocolType::MUL_OFF:
             HandleImpl<DefaultCalculator>(data, node, network_node, ctx);
@@ -84,6 +85,7 @@ void MulOffProtocol::HandleImpl(const std::vector<uint8_t>& data, Node& node,
 
 void MulOffJointSharingPrepareProtocol::Handle(Node& node, bool is_bit_mul) {
     const auto& conditions = node.GetConditions();
+    const uint64_t counter = node.ReserveCounters(RandomDomain::kMul, 5 * conditions.size());
     for (std::size_t condition_id = 0; condition_id < conditions.size(); ++condition_id) {
         const auto& condition = conditions[condition_id];
 
@@ -99,7 +101,12 @@ void MulOffJointSharingPrepareProtocol::Handle(Node& node, bool is_bit_mul) {
                 continue;
             }
 
-            uint64_t alpha_xy_share = node.PRFEval(id + condition_id * 5);
+            // Known to every party but id, unless id is one of the condition's three owners.
+            const bool owner = id == condition.node_idx[0] || id == condition.node_idx[1] ||
+                               id == condition.node_idx[2];
+            const PartySet holders = owner ? kAllParties : AllPartiesExcept(id);
+            uint64_t alpha_xy_share =
+                node.SubsetRandom(holders, counter + condition_id * 5 + id - 1);
             if (is_bit_mul) {
                 alpha_xy_share &= 1;
             }
@@ -128,14 +135,20 @@ void MulJointSharingProtocol::Handle(Node& node, NetworkNode& network_node,
                 matrix.Get(condition.node_idx[3], condition.node_idx[4]), share_sum);
             node.SetMulShares(val, condition.node_idx[4], i);
 
-            network_node.AddMessage(condition.node_idx[3], ctx.task_id, ctx.operation_id + i, val);
+            const JmpSenders senders = {condition.node_idx[0], condition.node_idx[1],
+                                        condition.node_idx[2]};
+            Calculator::SendJmp(network_node, condition.node_idx[3], ctx.task_id,
+                                ctx.operation_id + i, val, senders);
         }
     }
 
     const auto& condition_map = node.GetConditionMap();
     auto& receive_vector = condition_map.at(node_id);
     for (const auto& [index, share_id] : receive_vector) {
-        uint64_t val = network_node.Receive(ctx.task_id, ctx.operation_id + index, 3);
+        const auto& condition = conditions[index];
+        const JmpSenders senders = {condition.node_idx[0], condition.node_idx[1],
+                                    condition.node_idx[2]};
+        uint64_t val = network_node.ReceiveJmp(ctx.task_id, ctx.operation_id + index, senders);
         node.SetMulShares(val, share_id, index);
     }
 
@@ -150,6 +163,17 @@ void MulJointSharingProtocol::Handle(Node& node, NetworkNode& network_node,
     node.SetAlphaXY(xy_share);
 }
 
+// The parties that send beta_z to `receiver` in the online multiplication.
+static JmpSenders MulOnSenders(const int receiver) {
+    if (receiver == 1) {
+        return {3, 4, 5};
+    }
+    if (receiver <= 3) {
+        return {1, 4, 5};
+    }
+    return {1, 2, 3};
+}
+
 void MulOnProtocol::Handle(const std::vector<uint8_t>& data, Node& node, NetworkNode& network_node,
                            const TaskContext& ctx) {
     switch (data[0]) {
@@ -166,8 +190,9 @@ void MulOnProtocol::Handle(const std::vector<uint8_t>& data, Node& node, Network
 }
 
 template <typename Calculator>
-void MulOnProtocol::HandleImpl(const std::vector<uint8_t>& data, Node& node,
-                               NetworkNode& network_node, const TaskContext& ctx) {
+void MulOnProtocol::SendBetaZ(const std::vector<uint8_t>& data, Node& node,
+                              NetworkNode& network_node, const TaskContext& ctx,
+                              uint64_t (&beta_z)[5]) {
     const uint8_t node_id = node.ID();
     const uint32_t x_id = readUint32(data, 1);
     const uint32_t y_id = readUint32(data, 5);
@@ -175,12 +200,12 @@ void MulOnProtocol::HandleImpl(const std::vector<uint8_t>& data, Node& node,
 
     const CipherData cipher_x = node.BetaShares(x_id);
     const CipherData cipher_y = node.BetaShares(y_id);
-    CipherData& cipher_z = node.BetaShares(z_id);
+    const CipherData& cipher_z = node.BetaShares(z_id);
     const uint64_t beta_x = cipher_x.Beta();
     const uint64_t beta_y = cipher_y.Beta();
 
-    uint64_t beta_z[5] = {};
     for (uint8_t id = 1; id <= 5; ++id) {
+        beta_z[id - 1] = 0;
         if (id != node_id) {
             beta_z[id - 1] = Calculator::add(
                 Calculator::add(Calculator::sub(Calculator::zero(), beta_x * cipher_y.Alpha(id)),
@@ -190,26 +215,70 @@ void MulOnProtocol::HandleImpl(const std::vector<uint8_t>& data, Node& node,
     }
 
     if (node_id <= 3) {
-        network_node.AddMessage(4, ctx.task_id, ctx.operation_id + 3, beta_z[3]);
-        network_node.AddMessage(5, ctx.task_id, ctx.operation_id + 4, beta_z[4]);
+        Calculator::SendJmp(network_node, 4, ctx.task_id, ctx.operation_id + 3, beta_z[3],
+                            MulOnSenders(4));
+        Calculator::SendJmp(network_node, 5, ctx.task_id, ctx.operation_id + 4, beta_z[4],
+                            MulOnSenders(5));
     }
 
     if (node_id == 1 || node_id == 4 || node_id == 5) {
-        network_node.AddMessage(2, ctx.task_id, ctx.operation_id + 1, beta_z[1]);
-        network_node.AddMessage(3, ctx.task_id, ctx.operation_id + 2, beta_z[2]);
+        Calculator::SendJmp(network_node, 2, ctx.task_id, ctx.operation_id + 1, beta_z[1],
+                            MulOnSenders(2));
+        Calculator::SendJmp(network_node, 3, ctx.task_id, ctx.operation_id + 2, beta_z[2],
+                            MulOnSenders(3));
     }
 
     if (node_id == 3 || node_id == 4 || node_id == 5) {
-        network_node.AddMessage(1, ctx.task_id, ctx.operation_id, beta_z[0]);
+        Calculator::SendJmp(network_node, 1, ctx.task_id, ctx.operation_id, beta_z[0],
+                            MulOnSenders(1));
     }
+}
 
-    uint64_t receive_beta = network_node.Receive(ctx.task_id, ctx.operation_id + node_id - 1, 3);
-    beta_z[node_id - 1] = receive_beta;
+template <typename Calculator>
+void MulOnProtocol::CombineBetaZ(const std::vector<uint8_t>& data, Node& node,
+                                 const uint64_t (&beta_z)[5]) {
+    const uint32_t x_id = readUint32(data, 1);
+    const uint32_t y_id = readUint32(data, 5);
+    const uint32_t z_id = readUint32(data, 9);
+
+    const uint64_t beta_x = node.BetaShares(x_id).Beta();
+    const uint64_t beta_y = node.BetaShares(y_id).Beta();
     const uint64_t sum = Calculator::accumulate(std::begin(beta_z), std::end(beta_z));
     const uint64_t val = Calculator::add(sum, beta_x * beta_y);
-    cipher_z.SetBeta(val);
+    node.BetaShares(z_id).SetBeta(val);
     if (data[0] == ProtocolType::BIT_MUL_ON) {
         node.BitBetaToAdditive(z_id);
     }
-    // SPDLOG_INFO("Node {} final beta_z: {}", node_id, fmt::join(beta_z, ", "));
+    // SPDLOG_INFO("Node {} final beta_z: {}", node.ID(), fmt::join(beta_z, ", "));
+}
+
+template <typename Calculator>
+void MulOnProtocol::HandleImpl(const std::vector<uint8_t>& data, Node& node,
+                               NetworkNode& network_node, const TaskContext& ctx) {
+    const uint8_t node_id = node.ID();
+    uint64_t beta_z[5];
+    SendBetaZ<Calculator>(data, node, network_node, ctx, beta_z);
+    beta_z[node_id - 1] =
+        network_node.ReceiveJmp(ctx.task_id, ctx.operation_id + node_id - 1, MulOnSenders(node_id));
+    CombineBetaZ<Calculator>(data, node, beta_z);
+}
+
+ProtocolTask<> MulOnProtocol::HandleAsync(std::vector<uint8_t> data, Node& node,
+                                          NetworkNode& network_node, TaskContext ctx) {
+    if (data[0] == ProtocolType::BIT_MUL_ON) {
+        return HandleAsyncImpl<Mod2Calculator>(std::move(data), node, network_node, ctx);
+    }
+    return HandleAsyncImpl<DefaultCalculator>(std::move(data), node, network_node, ctx);
+}
+
+template <typename Calculator>
+ProtocolTask<> MulOnProtocol::HandleAsyncImpl(std::vector<uint8_t> data, Node& node,
+                                              NetworkNode& network_node, TaskContext ctx) {
+    const uint8_t node_id = node.ID();
+    uint64_t beta_z[5];
+    SendBetaZ<Calculator>(data, node, network_node, ctx, beta_z);
+    beta_z[node_id - 1] = co_await CoReceiveJmp(network_node, ctx.task_id,
+                                                ctx.operation_id + node_id - 1,
+                                                MulOnSenders(node_id));
+    CombineBetaZ<Calculator>(data, node, beta_z);
 }
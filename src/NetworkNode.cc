@@ -1,79 +1,297 @@
+#include <openssl/sha.h>
 #include <spdlog/spdlog.h>
+#include <algorithm>
+#include <bit>
 #include <iostream>
+#include <iterator>
 
+#include "LinkEmulator.h"
 #include "NetworkNode.h"
 
 NetworkNode::NetworkNode(int id, int io_threads,
-                         const std::unordered_map<int, std::string>& node_addresses)
-    : node_id_(id), context_(io_threads), router_(context_, ZMQ_ROUTER), stop_flag_(false) {
-    router_.bind(node_addresses.at(node_id_));
-    exit_pair_.bind("inproc://exit_" + std::to_string(node_id_));
+                         const std::unordered_map<int, std::string>& node_addresses,
+                         const NetworkOptions& options)
+    : NetworkNode(id, MakeTransport(id, io_threads, node_addresses), options) {
+    std::cout << "[Node " << node_id_ << "] Listening on " << node_addresses.at(node_id_)
+              << "...\n";
+}
+
+NetworkNode::NetworkNode(int id, std::unique_ptr<Transport> transport,
+                         const NetworkOptions& options)
+    : node_id_(id),
+      options_(options),
+      transport_(std::move(transport)),
+      stop_flag_(false),
+      receive_started_(std::chrono::steady_clock::now()) {
+    if (!options_.link_profile.empty()) {
+        transport_ = std::make_unique<LinkEmulator>(
+            std::move(transport_), LoadLinkProfiles(options_.link_profile, node_id_), node_id_);
+    }
+    const int shard_count = std::clamp(options_.sender_threads, 1, 4);
+    for (int i = 0; i < shard_count; i++) {
+        shards_.push_back(std::make_unique<SenderShard>());
+    }
+    int link = 0;
     for (int peer_id = 1; peer_id <= 5; peer_id++) {
         if (peer_id != node_id_) {
-            dealers_.emplace(std::piecewise_construct, std::forward_as_tuple(peer_id),
-                             std::forward_as_tuple(context_, ZMQ_DEALER));
-            dealers_[peer_id].connect(node_addresses.at(peer_id));
+            channels_[peer_id] = std::make_unique<PeerChannel>(options_.send_queue_capacity);
+            peer_shards_[peer_id] = shards_[link++ % shard_count].get();
+            peer_shards_[peer_id]->peers.push_back(peer_id);
         }
     }
-    std::cout << "[Node " << node_id_ << "] Listening on " << node_addresses.at(node_id_)
-              << "...\n";
+    bulk_buffers_.OnReturn([this] {
+        for (auto& shard : shards_) {
+            if (shard->bulk_throttled.load()) {
+                std::lock_guard<std::mutex> lock(shard->mutex);
+                shard->cv.notify_one();
+            }
+        }
+    });
+    const int dispatcher_count = std::clamp(options_.dispatch_threads, 0, kMaxDispatchThreads);
+    for (int i = 0; i < dispatcher_count; i++) {
+        dispatchers_.push_back(std::make_unique<Dispatcher>(1024));
+    }
+}
+
+NetworkNode::~NetworkNode() {
+    OutboundMessage msg{};
+    for (auto& channel : channels_) {
+        if (!channel) {
+            continue;
+        }
+        while (channel->queue.TryPop(msg)) {
+            delete[] msg.values;
+        }
+        while (channel->bulk_queue.TryPop(msg)) {
+            delete[] msg.values;
+        }
+    }
+}
+
+namespace {
+
+thread_local TrafficClass current_traffic_class = TrafficClass::kOnline;
+
+}  // namespace
+
+TrafficClassScope::TrafficClassScope(TrafficClass traffic_class)
+    : previous_(current_traffic_class) {
+    current_traffic_class = traffic_class;
+}
+
+TrafficClassScope::~TrafficClassScope() {
+    current_traffic_class = previous_;
+}
+
+TrafficClass TrafficClassScope::Current() {
+    return current_traffic_class;
+}
+
+void NetworkNode::Enqueue(const OutboundMessage& msg) {
+    if (msg.peer_id <= 0 || msg.peer_id >= static_cast<int>(channels_.size()) ||
+        !channels_[msg.peer_id]) {
+        std::cerr << "Invalid peer_id: " << msg.peer_id << std::endl;
+        delete[] msg.values;
+        return;
+    }
+    PeerChannel& channel = *channels_[msg.peer_id];
+    SenderShard& shard = *peer_shards_[msg.peer_id];
+    const bool bulk = options_.bulk_batches_in_flight > 0 &&
+                      TrafficClassScope::Current() == TrafficClass::kBulk;
+    MpscQueue<OutboundMessage>& queue = bulk ? channel.bulk_queue : channel.queue;
+    std::atomic<size_t>& pending = bulk ? shard.bulk_pending : shard.pending;
+
+    pending.fetch_add(1, std::memory_order_relaxed);
+    if (!queue.TryPush(msg)) {
+        // Make sure the sender is draining before we wait for it to free a slot.
+        shard.cv.notify_one();
+        if (!queue.Push(msg, stop_flag_)) {
+            pending.fetch_sub(1, std::memory_order_relaxed);
+            delete[] msg.values;
+            return;
+        }
+    }
+
+    if (pending.load(std::memory_order_relaxed) >= BATCH_SIZE) {
+        shard.cv.notify_one();
+    }
 }
 
 void NetworkNode::AddMessage(int peer_id, int task_id, int operation_id, uint64_t value) {
-    std::array<char, MSG_SIZE> msg;
-    snprintf(msg.data(), msg.size(), "%d-%d-%d-%" PRIu64, peer_id, task_id, operation_id, value);
+    Enqueue(OutboundMessage{peer_id, task_id, operation_id, 1, value, nullptr});
+}
 
-    if (!lockfree_queue_.push(msg)) {
-        std::cerr << "Queue is full, dropping message!\n";
-    } else {
-        total_msg_count_.fetch_add(1, std::memory_order_relaxed);
+void NetworkNode::AddBit(int peer_id, int task_id, int operation_id, uint64_t bit) {
+    if (bit > 1) {
+        AddMessage(peer_id, task_id, operation_id, bit);
+        return;
     }
+    Enqueue(OutboundMessage{peer_id, task_id, operation_id, 1, bit, nullptr, true});
+}
 
-    if (total_msg_count_.load(std::memory_order_relaxed) >= BATCH_SIZE) {
-        send_data_cv_.notify_one();
+void NetworkNode::AddMessages(int peer_id, int task_id, int operation_id,
+                              std::span<const uint64_t> values) {
+    if (values.empty()) {
+        return;
     }
+    if (values.size() == 1) {
+        AddMessage(peer_id, task_id, operation_id, values[0]);
+        return;
+    }
+    auto* block = new uint64_t[values.size()];
+    std::copy(values.begin(), values.end(), block);
+    Enqueue(OutboundMessage{peer_id, task_id, operation_id, static_cast<uint32_t>(values.size()),
+                            0, block});
 }
 
 void NetworkNode::SendMessages() {
+    std::vector<std::thread> extra_senders;
+    for (size_t i = 1; i < shards_.size(); i++) {
+        extra_senders.emplace_back(&NetworkNode::SenderLoop, this, std::ref(*shards_[i]));
+    }
+    SenderLoop(*shards_[0]);
+    for (auto& sender : extra_senders) {
+        sender.join();
+    }
+}
+
+size_t NetworkNode::EncodeBatch(MpscQueue<OutboundMessage>& queue, FrameWriter& writer,
+                                size_t limit) {
+    writer.Reset(node_id_);
+    OutboundMessage msg{};
+    size_t popped = 0;
+    while (popped < limit && queue.TryPop(msg)) {
+        ++popped;
+        if (msg.bits) {
+            writer.AppendBits(msg.task_id, msg.operation_id, &msg.value, 1);
+        } else if (msg.values != nullptr) {
+            writer.Append(msg.task_id, msg.operation_id, msg.values, msg.count);
+            delete[] msg.values;
+        } else {
+            writer.Append(msg.task_id, msg.operation_id, msg.value);
+        }
+    }
+    return popped;
+}
+
+void NetworkNode::SendBatch(int peer_id, FrameWriter& writer, BufferPool& pool) {
+    // The transport takes the encoded bytes as they are and hands the buffer back to the pool
+    // once it has been written out.
+    PooledBuffer* batch = pool.Acquire();
+    writer.SwapBuffer(batch->bytes);
+    batches_sent_.fetch_add(1, std::memory_order_relaxed);
+    bytes_sent_.fetch_add(batch->bytes.size(), std::memory_order_relaxed);
+    transport_->Send(peer_id, batch);
+}
+
+void NetworkNode::SenderLoop(SenderShard& shard) {
+    const size_t bulk_limit = static_cast<size_t>(std::max(options_.bulk_batches_in_flight, 0));
     while (!stop_flag_.load()) {
         {
-            std::unique_lock<std::mutex> lock(send_data_mutex_);
-            send_data_cv_.wait_for(lock, std::chrono::milliseconds(WAIT_TIME), [&] {
-                return stop_flag_.load() || total_msg_count_.load() >= BATCH_SIZE;
+            std::unique_lock<std::mutex> lock(shard.mutex);
+            shard.cv.wait_for(lock, std::chrono::milliseconds(WAIT_TIME), [&] {
+                if (stop_flag_.load() || shard.pending.load() >= BATCH_SIZE ||
+                    shard.flush_requested.load()) {
+                    return true;
+                }
+                // Throttled bulk traffic goes as soon as a bulk batch has left the transport.
+                return shard.bulk_throttled.load() ? bulk_buffers_.InUse() < bulk_limit
+                                                   : shard.bulk_pending.load() >= BATCH_SIZE;
             });
         }
+        // A flush drains everything queued so far; otherwise send one batch per peer at a time.
+        const size_t limit = shard.flush_requested.exchange(false) ? SIZE_MAX : BATCH_SIZE;
 
-        if (total_msg_count_.load(std::memory_order_relaxed) == 0) {
+        if (shard.pending.load(std::memory_order_relaxed) == 0 &&
+            shard.bulk_pending.load(std::memory_order_relaxed) == 0) {
             continue;
         }
 
-        std::array<char, MSG_SIZE> msg;
-        std::vector<std::array<char, MSG_SIZE>> batch;
-        batch.reserve(BATCH_SIZE);
+        shard.bulk_throttled.store(false);
+        for (const int peer_id : shard.peers) {
+            PeerChannel& channel = *channels_[peer_id];
+            FrameWriter& writer = channel.writer;
+
+            const size_t popped = EncodeBatch(channel.queue, writer, limit);
+            if (!writer.Empty()) {
+                SendBatch(peer_id, writer, send_buffers_);
+            }
+            // Counted down only now so that Drain() cannot see an empty shard mid-send.
+            shard.pending.fetch_sub(popped, std::memory_order_relaxed);
 
-        while (batch.size() < BATCH_SIZE && lockfree_queue_.pop(msg)) {
-            batch.push_back(msg);
+            if (shard.bulk_pending.load(std::memory_order_relaxed) == 0) {
+                continue;
+            }
+            if (bulk_buffers_.InUse() >= bulk_limit) {
+                shard.bulk_throttled.store(true);
+                bulk_throttles_.fetch_add(1, std::memory_order_relaxed);
+                continue;
+            }
+            const size_t bulk_popped = EncodeBatch(channel.bulk_queue, writer, limit);
+            if (!writer.Empty()) {
+                SendBatch(peer_id, writer, bulk_buffers_);
+                bulk_batches_sent_.fetch_add(1, std::memory_order_relaxed);
+            }
+            shard.bulk_pending.fetch_sub(bulk_popped, std::memory_order_relaxed);
         }
-        total_msg_count_.fetch_sub(batch.size(), std::memory_order_relaxed);
+    }
+}
 
-        std::unordered_map<int, std::string> batched_messages;
-        for (const auto& message : batch) {
-            std::string_view msg_view(message.data());
-            size_t pos1 = msg_view.find('-');
-            int peer_id = std::stoi(std::string(msg_view.substr(0, pos1)));
-            std::string updated_message =
-                std::to_string(node_id_) + std::string(msg_view.substr(pos1));
-            batched_messages[peer_id] += updated_message + "|";
+void NetworkNode::Flush() {
+    for (auto& shard : shards_) {
+        if (shard->pending.load(std::memory_order_relaxed) == 0 &&
+            shard->bulk_pending.load(std::memory_order_relaxed) == 0) {
+            continue;
+        }
+        {
+            // Taking the lock orders the flag store with the sender's predicate check.
+            std::lock_guard<std::mutex> lock(shard->mutex);
+            shard->flush_requested.store(true);
         }
+        shard->cv.notify_one();
+    }
+}
 
-        for (auto& [peer_id, full_message] : batched_messages) {
-            if (dealers_.count(peer_id)) {
-                dealers_[peer_id].send(zmq::message_t(full_message), zmq::send_flags::none);
-            } else {
-                std::cerr << "Invalid peer_id: " << peer_id << std::endl;
-            }
+void NetworkNode::ExchangeControl(int operation_id) {
+    for (int peer_id = 1; peer_id <= 5; peer_id++) {
+        if (peer_id != node_id_) {
+            AddMessage(peer_id, kControlTaskId, operation_id, node_id_);
         }
     }
+    Flush();
+    uint64_t senders[4];
+    Collect(kControlTaskId, operation_id, 4, senders);
+}
+
+void NetworkNode::WaitForPeers() {
+    ExchangeControl(0);
+}
+
+void NetworkNode::Drain() {
+    // Links are FIFO, so a peer's DRAIN marker arrives after all of its earlier traffic; its
+    // DRAINED marker is sent only once our DRAIN has arrived, which acknowledges ours. Online
+    // markers overtake queued bulk messages, so those have to be handed over first.
+    const auto bulk_queued = [this] {
+        return std::any_of(shards_.begin(), shards_.end(), [](const auto& shard) {
+            return shard->bulk_pending.load(std::memory_order_relaxed) > 0;
+        });
+    };
+    while (!stop_flag_.load() && bulk_queued()) {
+        Flush();
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+    ExchangeControl(1);
+    ExchangeControl(2);
+    const auto queued = [this] {
+        return std::any_of(shards_.begin(), shards_.end(), [](const auto& shard) {
+            return shard->pending.load(std::memory_order_relaxed) > 0;
+        });
+    };
+    while (!stop_flag_.load() && queued()) {
+        Flush();
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+    transport_->WaitSent();
 }
 
 uint64_t NetworkNode::Jmp(const uint64_t va, const uint64_t vb, const uint64_t vc) {
@@ -81,6 +299,13 @@ uint64_t NetworkNode::Jmp(const uint64_t va, const uint64_t vb, const uint64_t v
 }
 
 std::shared_ptr<TaskQueue> NetworkNode::GetOrCreateTaskQueue(int task_id) {
+    {
+        std::shared_lock<std::shared_mutex> lock(map_mutex_);
+        auto it = task_queues_.find(task_id);
+        if (it != task_queues_.end()) {
+            return it->second;
+        }
+    }
     std::unique_lock<std::shared_mutex> lock(map_mutex_);
     auto& queue = task_queues_[task_id];
     if (!queue) {
@@ -89,97 +314,674 @@ std::shared_ptr<TaskQueue> NetworkNode::GetOrCreateTaskQueue(int task_id) {
     return queue;
 }
 
-uint64_t NetworkNode::Receive(int task_id, int operation_id, size_t peer_count) {
-    std::vector<uint64_t> received;
-    received.reserve(peer_count);
-    auto queue = GetOrCreateTaskQueue(task_id);
-
-    while (received.size() < peer_count) {
-        std::unique_lock<std::mutex> lock(queue->mutex);
-        queue->cv.wait(lock, [&]() {
-            return stop_flag_.load() ||
-                   std::any_of(queue->data.begin(), queue->data.end(),
-                               [operation_id](const auto& p) { return p.first == operation_id; });
-        });
+void NetworkNode::OpenTask(int task_id) {
+    GetOrCreateTaskQueue(task_id);
+}
+
+void NetworkNode::CloseTask(int task_id) {
+    {
+        std::lock_guard<std::mutex> lock(jmp_mutex_);
+        jmp_states_.erase(task_id);
+    }
+    ReclaimTaskQueue(task_id);
+}
+
+void NetworkNode::ReclaimTaskQueue(int task_id) {
+    std::unique_lock<std::shared_mutex> map_lock(map_mutex_);
+    auto it = task_queues_.find(task_id);
+    if (it == task_queues_.end()) {
+        return;
+    }
+    TaskQueue& queue = *it->second;
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    // Collect() erases operations as they drain, so anything left is unread, still awaited or
+    // owed a late copy.
+    if (!queue.operations.empty()) {
+        queue.close_requested = true;
+        return;
+    }
+    queue.closed = true;
+    task_queues_.erase(it);
+}
+
+std::shared_ptr<TaskQueue> NetworkNode::LockTaskQueue(int task_id,
+                                                      std::unique_lock<std::mutex>& lock) {
+    std::shared_ptr<TaskQueue> queue;
+    do {
+        // A concurrent CloseTask may have unlinked the queue we found; use the new one.
+        queue = GetOrCreateTaskQueue(task_id);
+        lock = std::unique_lock<std::mutex>(queue->mutex);
+    } while (queue->closed);
+    return queue;
+}
+
+void NetworkNode::RecordStraggler(const int sender,
+                                  const std::chrono::steady_clock::duration lateness) {
+    if (sender < 1 || sender > 5) {
+        return;
+    }
+    const auto us = std::chrono::duration_cast<std::chrono::microseconds>(lateness).count();
+    const int bucket =
+        us <= 0 ? 0
+                : std::min<int>(std::bit_width(static_cast<uint64_t>(us)), kStragglerBuckets - 1);
+    stragglers_[sender][bucket].fetch_add(1, std::memory_order_relaxed);
+}
+
+namespace {
+
+// Chains (operation id, value) into the running SHA-256 digest of a JMP link.
+void FoldJmp(JmpChain& chain, const int operation_id, const uint64_t value) {
+    uint8_t block[32 + 4 + 8];
+    std::memcpy(block, chain.digest.data(), chain.digest.size());
+    StoreLE32(block + 32, static_cast<uint32_t>(operation_id));
+    StoreLE64(block + 36, value);
+    SHA256(block, sizeof(block), chain.digest.data());
+    chain.values.push_back(value);
+}
+
+uint64_t DigestWord(const JmpChain& chain) {
+    return LoadLE64(chain.digest.data());
+}
+
+}  // namespace
+
+int NetworkNode::JmpDesignated(const int peer_id, JmpSenders senders) {
+    std::sort(senders.begin(), senders.end());
+    return senders[peer_id % 3];
+}
+
+void NetworkNode::SendJmp(int peer_id, int task_id, int operation_id, uint64_t value,
+                          const JmpSenders& senders, bool bit) {
+    if (options_.jmp_digests && JmpDesignated(peer_id, senders) != node_id_) {
+        std::lock_guard<std::mutex> lock(jmp_mutex_);
+        FoldJmp(jmp_states_[task_id].sent.at(peer_id), operation_id, value);
+        jmp_copies_digested_.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    if (bit) {
+        AddBit(peer_id, task_id, operation_id, value);
+    } else {
+        AddMessage(peer_id, task_id, operation_id, value);
+    }
+}
+
+uint64_t NetworkNode::ReceiveJmp(int task_id, int operation_id, const JmpSenders& senders) {
+    if (!options_.jmp_digests) {
+        return Receive(task_id, operation_id, 3);
+    }
+    const uint64_t value = Receive(task_id, operation_id, 1);
+    AcceptJmp(task_id, operation_id, senders, value);
+    return value;
+}
+
+void NetworkNode::ReceiveJmpAsync(int task_id, int operation_id, const JmpSenders& senders,
+                                  std::function<void(uint64_t)> done) {
+    if (!options_.jmp_digests) {
+        ReceiveAsync(task_id, operation_id, 3, std::move(done));
+        return;
+    }
+    ReceiveAsync(task_id, operation_id, 1,
+                 [this, task_id, operation_id, senders, done = std::move(done)](uint64_t value) {
+                     AcceptJmp(task_id, operation_id, senders, value);
+                     done(value);
+                 });
+}
+
+void NetworkNode::AcceptJmp(int task_id, int operation_id, const JmpSenders& senders,
+                            uint64_t value) {
+    const int designated = JmpDesignated(node_id_, senders);
+
+    std::lock_guard<std::mutex> lock(jmp_mutex_);
+    JmpState& state = jmp_states_[task_id];
+    JmpEntry entry{};
+    size_t slot = 0;
+    for (const int sender : senders) {
+        if (sender == designated || slot == entry.senders.size()) {
+            continue;
+        }
+        JmpChain& chain = state.received.at(sender);
+        entry.senders[slot] = sender;
+        entry.positions[slot] = static_cast<uint32_t>(chain.values.size());
+        ++slot;
+        FoldJmp(chain, operation_id, value);
+    }
+    state.accepted.push_back(entry);
+}
+
+bool NetworkNode::VerifyJmp(int task_id, int operation_id) {
+    if (!options_.jmp_digests) {
+        return true;
+    }
+    JmpState state;
+    {
+        std::lock_guard<std::mutex> lock(jmp_mutex_);
+        auto it = jmp_states_.find(task_id);
+        if (it != jmp_states_.end()) {
+            state = std::move(it->second);
+            jmp_states_.erase(it);
+        }
+    }
+
+    // Every party talks to every other one, even with nothing digested, so the rounds line up.
+    // Operation ids are offset by the sending party to tell the copies apart.
+    for (int peer_id = 1; peer_id <= 5; peer_id++) {
+        if (peer_id != node_id_) {
+            AddMessage(peer_id, task_id, operation_id + node_id_, DigestWord(state.sent[peer_id]));
+        }
+    }
+    std::array<bool, 6> mismatch{};
+    for (int sender = 1; sender <= 5; sender++) {
+        if (sender != node_id_) {
+            mismatch[sender] = Receive(task_id, operation_id + sender, 1) !=
+                               DigestWord(state.received[sender]);
+        }
+    }
+
+    // Ask the disagreeing senders for the copies they only digested. The copies are preceded
+    // by their count, so an empty or desynchronised chain still answers and is read in full.
+    for (int peer_id = 1; peer_id <= 5; peer_id++) {
+        if (peer_id != node_id_) {
+            AddMessage(peer_id, task_id, operation_id + 5 + node_id_, mismatch[peer_id] ? 1 : 0);
+        }
+    }
+    for (int sender = 1; sender <= 5; sender++) {
+        if (sender != node_id_ && Receive(task_id, operation_id + 5 + sender, 1) != 0) {
+            const std::vector<uint64_t>& values = state.sent[sender].values;
+            AddMessage(sender, task_id, operation_id + 10 + node_id_, values.size());
+            AddMessages(sender, task_id, operation_id + 10 + node_id_, values);
+        }
+    }
+    bool verified = true;
+    std::array<std::vector<uint64_t>, 6> copies;
+    for (int sender = 1; sender <= 5; sender++) {
+        if (mismatch[sender]) {
+            jmp_mismatches_.fetch_add(1, std::memory_order_relaxed);
+            spdlog::warn("Node {}: JMP digest from node {} disagrees in task {}", node_id_, sender,
+                         task_id);
+            copies[sender].resize(Receive(task_id, operation_id + 10 + sender, 1));
+            if (!copies[sender].empty()) {
+                ReceiveVector(task_id, operation_id + 10 + sender, copies[sender], 1);
+            }
+            if (copies[sender].size() != state.received[sender].values.size()) {
+                spdlog::warn("Node {}: node {} sent {} JMP copies, expected {}", node_id_, sender,
+                             copies[sender].size(), state.received[sender].values.size());
+                verified = false;
+            }
+        }
+    }
+
+    // A value confirmed by one matching digest has two agreeing copies; otherwise vote.
+    for (const JmpEntry& entry : state.accepted) {
+        const int a = entry.senders[0];
+        const int b = entry.senders[1];
+        if (!mismatch[a] || !mismatch[b]) {
+            continue;
+        }
+        if (copies[a].size() != state.received[a].values.size() ||
+            copies[b].size() != state.received[b].values.size()) {
+            continue;  // already failed above
+        }
+        const uint64_t designated = state.received[a].values[entry.positions[0]];
+        if (Jmp(designated, copies[a][entry.positions[0]], copies[b][entry.positions[1]]) !=
+            designated) {
+            verified = false;
+        }
+    }
+    if (!verified) {
+        spdlog::error("Node {}: JMP verification failed in task {}", node_id_, task_id);
+    }
+    return verified;
+}
+
+void NetworkNode::Collect(int task_id, int operation_id, size_t total, uint64_t* dst) {
+    if (options_.auto_flush) {
+        // Whatever this round queued must leave before we can expect the peers' replies.
+        Flush();
+    }
+    receive_calls_.fetch_add(1, std::memory_order_relaxed);
+    size_t received = 0;
+    std::unique_lock<std::mutex> lock;
+    std::shared_ptr<TaskQueue> queue = LockTaskQueue(task_id, lock);
+    // unordered_map never relocates its elements, so the reference survives other inserts.
+    OperationBuffer& op = queue->operations[operation_id];
+    while (received < total) {
+        ++op.waiters;
+        op.cv.wait(lock, [&]() { return stop_flag_.load() || op.Available() > 0; });
+        --op.waiters;
 
         if (stop_flag_.load()) {
             throw std::runtime_error("Node is stopping");
         }
 
-        auto it = std::find_if(queue->data.begin(), queue->data.end(),
-                               [operation_id](const auto& p) { return p.first == operation_id; });
+        const size_t to_take = std::min(total - received, op.Available());
+        const auto begin = op.values.begin() + static_cast<std::ptrdiff_t>(op.consumed);
+        std::copy(begin, begin + static_cast<std::ptrdiff_t>(to_take), dst + received);
+        received += to_take;
+        op.consumed += to_take;
+        if (op.Available() == 0) {
+            op.values.clear();
+            op.origins.clear();
+            op.consumed = 0;
+        }
+    }
+
+    if (op.Idle()) {
+        queue->operations.erase(operation_id);
+    }
+}
+
+bool NetworkNode::CanTake(const OperationBuffer& op, size_t peer_count) const {
+    if (peer_count == 1) {
+        return op.Available() >= 1;
+    }
+    if (op.Available() >= 3) {
+        return true;
+    }
+    // Only one early accept per operation can wait for its late copy at a time. Two copies from
+    // one sender are this use and a faster peer's next use of the operation, not a majority.
+    return options_.early_accept && !op.late && op.Available() == 2 &&
+           op.origins[op.consumed].sender != op.origins[op.consumed + 1].sender &&
+           op.values[op.consumed] == op.values[op.consumed + 1];
+}
+
+uint64_t NetworkNode::Take(OperationBuffer& op, size_t peer_count) {
+    const uint64_t* values = op.values.data() + op.consumed;
+    const ValueOrigin* origins = op.origins.data() + op.consumed;
+    uint64_t result;
+    if (peer_count == 1) {
+        result = values[0];
+        op.consumed += 1;
+    } else if (op.Available() >= 3) {
+        result = Jmp(values[0], values[1], values[2]);
+        RecordStraggler(origins[2].sender, origins[2].arrived - origins[1].arrived);
+        op.consumed += 3;
+    } else {
+        result = values[0];
+        op.late = LateCopy{{origins[0].sender, origins[1].sender}, result, origins[1].arrived};
+        early_accepts_.fetch_add(1, std::memory_order_relaxed);
+        op.consumed += 2;
+    }
+    if (op.Available() == 0) {
+        op.values.clear();
+        op.origins.clear();
+        op.consumed = 0;
+    }
+    return result;
+}
+
+uint64_t NetworkNode::ReceiveMajority(int task_id, int operation_id) {
+    if (options_.auto_flush) {
+        Flush();
+    }
+    receive_calls_.fetch_add(1, std::memory_order_relaxed);
+    std::unique_lock<std::mutex> lock;
+    std::shared_ptr<TaskQueue> queue = LockTaskQueue(task_id, lock);
+    OperationBuffer& op = queue->operations[operation_id];
+
+    ++op.waiters;
+    op.cv.wait(lock, [&]() { return stop_flag_.load() || CanTake(op, 3); });
+    --op.waiters;
+
+    if (stop_flag_.load()) {
+        throw std::runtime_error("Node is stopping");
+    }
+
+    const uint64_t result = Take(op, 3);
+    if (op.Idle()) {
+        queue->operations.erase(operation_id);
+    }
+    return result;
+}
+
+void NetworkNode::ServePending(OperationBuffer& op, ReadyReceives& ready) {
+    while (!op.pending.empty() && CanTake(op, op.pending.front().peer_count)) {
+        PendingReceive& next = op.pending.front();
+        const uint64_t value = Take(op, next.peer_count);
+        ready.emplace_back(std::move(next.done), value);
+        op.pending.pop_front();
+    }
+}
+
+void NetworkNode::RunContinuations(ReadyReceives& ready) {
+    for (auto& [done, value] : ready) {
+        try {
+            done(value);
+        } catch (const std::exception& e) {
+            spdlog::error("Node {}: receive continuation threw: {}", node_id_, e.what());
+        }
+    }
+    ready.clear();
+}
+
+void NetworkNode::ReceiveAsync(int task_id, int operation_id, size_t peer_count,
+                               std::function<void(uint64_t)> done) {
+    if (peer_count != 1 && peer_count != 3) {
+        throw std::invalid_argument("ReceiveAsync supports 1 or 3 peers");
+    }
+    if (options_.auto_flush) {
+        Flush();
+    }
+    receive_calls_.fetch_add(1, std::memory_order_relaxed);
+    ReadyReceives ready;
+    {
+        std::unique_lock<std::mutex> lock;
+        std::shared_ptr<TaskQueue> queue = LockTaskQueue(task_id, lock);
+        OperationBuffer& op = queue->operations[operation_id];
+        op.pending.push_back(PendingReceive{peer_count, std::move(done)});
+        ServePending(op, ready);
+        if (op.Idle()) {
+            queue->operations.erase(operation_id);
+        }
+    }
+    RunContinuations(ready);
+}
+
+std::future<uint64_t> NetworkNode::ReceiveAsync(int task_id, int operation_id,
+                                                size_t peer_count) {
+    // std::function needs a copyable target, so the promise is shared.
+    auto promise = std::make_shared<std::promise<uint64_t>>();
+    std::future<uint64_t> future = promise->get_future();
+    ReceiveAsync(task_id, operation_id, peer_count,
+                 [promise](uint64_t value) { promise->set_value(value); });
+    return future;
+}
 
-        if (it != queue->data.end()) {
-            size_t to_take = std::min(peer_count - received.size(), it->second.size());
-            received.insert(received.end(), it->second.begin(), it->second.begin() + to_take);
-            it->second.erase(it->second.begin(), it->second.begin() + to_take);
+uint64_t NetworkNode::Receive(int task_id, int operation_id, size_t peer_count) {
+    if (peer_count != 1 && peer_count != 3) {
+        throw std::invalid_argument("Receive supports 1 or 3 peers");
+    }
+    if (peer_count == 3) {
+        return ReceiveMajority(task_id, operation_id);
+    }
+    uint64_t received = 0;
+    Collect(task_id, operation_id, 1, &received);
+    return received;
+}
 
-            if (it->second.empty()) {
-                queue->data.erase(it);
+void NetworkNode::ReceiveVector(int task_id, int operation_id, std::span<uint64_t> out,
+                                size_t peer_count) {
+    const size_t count = out.size();
+    if (count == 0) {
+        return;
+    }
+    if (peer_count == 1) {
+        Collect(task_id, operation_id, count, out.data());
+        return;
+    }
+    if (peer_count != 3) {
+        throw std::invalid_argument("ReceiveVector supports 1 or 3 peers");
+    }
+
+    // Each sender's block arrives as one contiguous frame, so the copies are laid out as
+    // [sender a][sender b][sender c] in arrival order.
+    thread_local std::vector<uint64_t> copies;
+    copies.resize(count * 3);
+    Collect(task_id, operation_id, copies.size(), copies.data());
+    for (size_t i = 0; i < count; ++i) {
+        out[i] = Jmp(copies[i], copies[count + i], copies[2 * count + i]);
+    }
+}
+
+void NetworkNode::DispatchBatch(const void* data, size_t size, int shard) {
+    FrameReader reader(data, size);
+    const int sender = reader.SenderID();
+    const auto arrived = std::chrono::steady_clock::now();
+    thread_local ReadyReceives ready;
+    FrameView frame{};
+    while (reader.Next(frame)) {
+        if (shard >= 0 && ShardOf(frame.task_id) != shard) {
+            continue;
+        }
+        std::unique_lock<std::mutex> lock;
+        std::shared_ptr<TaskQueue> queue = LockTaskQueue(frame.task_id, lock);
+        OperationBuffer& op = queue->operations[frame.operation_id];
+
+        uint32_t first = 0;
+        // Links are FIFO, so the first copy from a third party is the one the early accept owes.
+        if (op.late && frame.count > 0 && sender != op.late->contributors[0] &&
+            sender != op.late->contributors[1]) {
+            late_copies_.fetch_add(1, std::memory_order_relaxed);
+            if (frame.Value(0) != op.late->value) {
+                late_mismatches_.fetch_add(1, std::memory_order_relaxed);
+                spdlog::warn("Node {}: late copy from node {} disagrees in task {} operation {}",
+                             node_id_, sender, frame.task_id, frame.operation_id);
+            }
+            RecordStraggler(sender, arrived - op.late->accepted_at);
+            op.late.reset();
+            first = 1;
+        }
+        for (uint32_t i = first; i < frame.count; ++i) {
+            op.values.push_back(frame.Value(i));
+            op.origins.push_back(ValueOrigin{sender, arrived});
+        }
+        if (op.waiters > 0) {
+            op.cv.notify_all();
+        }
+        ServePending(op, ready);
+
+        if (op.Idle()) {
+            queue->operations.erase(frame.operation_id);
+            if (queue->operations.empty() && queue->close_requested) {
+                lock.unlock();
+                ReclaimTaskQueue(frame.task_id);
             }
         }
     }
+    RunContinuations(ready);
+}
+
+void NetworkNode::RouteBatch(const void* data, size_t size) {
+    uint32_t owners = 0;
+    FrameReader reader(data, size);
+    FrameView frame{};
+    while (reader.Next(frame)) {
+        owners |= 1u << ShardOf(frame.task_id);
+    }
+    if (owners == 0) {
+        return;
+    }
 
-    if (peer_count == 1)
-        return received[0];
-    if (peer_count == 3)
-        return Jmp(received[0], received[1], received[2]);
-    return 0;
+    // One copy serves every owner; each dispatcher skips the frames of the other shards.
+    PooledBuffer* batch = inbound_buffers_.Acquire();
+    const auto* bytes = static_cast<const uint8_t*>(data);
+    batch->bytes.assign(bytes, bytes + size);
+    batch->readers.store(std::popcount(owners), std::memory_order_relaxed);
+    for (int shard = 0; owners != 0; shard++, owners >>= 1) {
+        if ((owners & 1) == 0) {
+            continue;
+        }
+        Dispatcher& dispatcher = *dispatchers_[shard];
+        if (!dispatcher.queue.Push(batch, stop_flag_)) {
+            if (batch->readers.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                inbound_buffers_.Put(batch);
+            }
+            continue;
+        }
+        // Pairs with the fence in DispatcherLoop: either it sees the batch or we see it asleep.
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (dispatcher.sleeping.load(std::memory_order_relaxed)) {
+            std::lock_guard<std::mutex> lock(dispatcher.mutex);
+            dispatcher.cv.notify_one();
+        }
+    }
+}
+
+void NetworkNode::DispatcherLoop(Dispatcher& dispatcher, int shard) {
+    constexpr int kSpinPolls = 256;
+    int idle_polls = 0;
+    PooledBuffer* batch = nullptr;
+    while (true) {
+        if (!dispatcher.queue.TryPop(batch)) {
+            if (stop_flag_.load()) {
+                break;
+            }
+            if (++idle_polls < kSpinPolls) {
+                std::this_thread::yield();
+                continue;
+            }
+            std::unique_lock<std::mutex> lock(dispatcher.mutex);
+            dispatcher.sleeping.store(true, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            const bool popped = dispatcher.queue.TryPop(batch);
+            if (!popped && !stop_flag_.load()) {
+                // The timeout only guards Stop(); RouteBatch wakes us for every batch.
+                dispatcher.cv.wait_for(lock, std::chrono::milliseconds(WAIT_TIME));
+            }
+            dispatcher.sleeping.store(false, std::memory_order_relaxed);
+            if (!popped) {
+                continue;
+            }
+        }
+        idle_polls = 0;
+
+        const auto start = std::chrono::steady_clock::now();
+        DispatchBatch(batch->bytes.data(), batch->bytes.size(), shard);
+        if (batch->readers.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            inbound_buffers_.Put(batch);
+        }
+        dispatcher.busy_ns.fetch_add(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - start)
+                .count(),
+            std::memory_order_relaxed);
+        dispatcher.batches.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // Batches still queued at Stop() are dropped; other dispatchers may hold them too.
+    while (dispatcher.queue.TryPop(batch)) {
+        if (batch->readers.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            inbound_buffers_.Put(batch);
+        }
+    }
 }
 
 void NetworkNode::ReceiveMessages() {
-    zmq::pollitem_t items[] = {{static_cast<void*>(router_), 0, ZMQ_POLLIN, 0},
-                               {static_cast<void*>(exit_pair_), 0, ZMQ_POLLIN, 0}};
+    std::vector<std::thread> dispatcher_threads;
+    for (size_t i = 0; i < dispatchers_.size(); i++) {
+        dispatcher_threads.emplace_back(&NetworkNode::DispatcherLoop, this,
+                                        std::ref(*dispatchers_[i]), static_cast<int>(i));
+    }
+
+    const BatchHandler dispatch = [this](const void* data, size_t size) {
+        if (!dispatchers_.empty()) {
+            RouteBatch(data, size);
+            return;
+        }
+        const auto start = std::chrono::steady_clock::now();
+        DispatchBatch(data, size);
+        inline_busy_ns_.fetch_add(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                      std::chrono::steady_clock::now() - start)
+                                      .count(),
+                                  std::memory_order_relaxed);
+        inline_batches_.fetch_add(1, std::memory_order_relaxed);
+    };
 
+    int idle_polls = 0;
     while (!stop_flag_.load()) {
-        zmq::poll(items, 2, std::chrono::milliseconds(0));
-
-        if (items[0].revents & ZMQ_POLLIN) {
-            zmq::message_t sender, message;
-            (void)router_.recv(sender, zmq::recv_flags::none);
-            (void)router_.recv(message, zmq::recv_flags::none);
-            std::string msg_str = message.to_string();
-
-            std::unordered_map<int, std::unordered_map<int, std::vector<uint64_t>>> batch_data;
-
-            size_t pos = 0;
-            while (pos < msg_str.size()) {
-                size_t next_pos = msg_str.find('|', pos);
-                std::string single_msg = msg_str.substr(pos, next_pos - pos);
-                pos = (next_pos == std::string::npos) ? msg_str.size() : next_pos + 1;
-
-                int received_task_id, operation_id, sender_id;
-                uint64_t value;
-                if (sscanf(single_msg.c_str(), "%d-%d-%d-%" PRIu64, &sender_id, &received_task_id,
-                           &operation_id, &value) == 4) {
-                    batch_data[received_task_id][operation_id].push_back(value);
-                }
-            }
+        const bool block = options_.receive_mode == ReceiveMode::kBlocking ||
+                           (options_.receive_mode == ReceiveMode::kAdaptive &&
+                            idle_polls >= options_.spin_budget);
+        bool received;
+        if (block) {
+            // Stop() interrupts the transport, so an indefinite wait cannot outlive the node.
+            received = transport_->Poll(std::chrono::milliseconds(-1), dispatch);
+            blocking_wakeups_.fetch_add(1, std::memory_order_relaxed);
+        } else {
+            received = transport_->Poll(std::chrono::milliseconds(0), dispatch);
+        }
 
-            for (auto& [task_id, op_map] : batch_data) {
-                auto queue = GetOrCreateTaskQueue(task_id);
-                std::lock_guard<std::mutex> lock(queue->mutex);
-                for (auto& [operation_id, values] : op_map) {
-                    auto it = std::find_if(
-                        queue->data.begin(), queue->data.end(),
-                        [operation_id](const auto& p) { return p.first == operation_id; });
-                    if (it != queue->data.end()) {
-                        it->second.insert(it->second.end(), values.begin(), values.end());
-                    } else {
-                        queue->data.emplace_back(operation_id, values);
-                    }
-                }
-                queue->cv.notify_one();
-            }
+        if (received) {
+            idle_polls = 0;
+        } else if (!block) {
+            ++idle_polls;
+            spin_iterations_.fetch_add(1, std::memory_order_relaxed);
         }
     }
+
+    for (auto& dispatcher : dispatcher_threads) {
+        dispatcher.join();
+    }
+}
+
+NetworkStats NetworkNode::Stats() const {
+    NetworkStats stats{};
+    stats.spin_iterations = spin_iterations_.load(std::memory_order_relaxed);
+    stats.blocking_wakeups = blocking_wakeups_.load(std::memory_order_relaxed);
+    for (const auto& channel : channels_) {
+        if (channel) {
+            stats.send_queue_high_water_mark =
+                std::max({stats.send_queue_high_water_mark, channel->queue.HighWaterMark(),
+                          channel->bulk_queue.HighWaterMark()});
+            stats.send_queue_parks += channel->queue.Parks() + channel->bulk_queue.Parks();
+        }
+    }
+    stats.batches_sent = batches_sent_.load(std::memory_order_relaxed);
+    stats.bytes_sent = bytes_sent_.load(std::memory_order_relaxed);
+    stats.send_buffer_allocations = send_buffers_.Allocations() + bulk_buffers_.Allocations();
+    stats.bulk_batches_sent = bulk_batches_sent_.load(std::memory_order_relaxed);
+    stats.bulk_throttles = bulk_throttles_.load(std::memory_order_relaxed);
+    stats.receive_calls = receive_calls_.load(std::memory_order_relaxed);
+    stats.jmp_copies_digested = jmp_copies_digested_.load(std::memory_order_relaxed);
+    stats.jmp_mismatches = jmp_mismatches_.load(std::memory_order_relaxed);
+    stats.early_accepts = early_accepts_.load(std::memory_order_relaxed);
+    stats.late_copies = late_copies_.load(std::memory_order_relaxed);
+    stats.late_mismatches = late_mismatches_.load(std::memory_order_relaxed);
+    for (int peer_id = 1; peer_id <= 5; peer_id++) {
+        for (int bucket = 0; bucket < kStragglerBuckets; bucket++) {
+            stats.stragglers[peer_id][bucket] =
+                stragglers_[peer_id][bucket].load(std::memory_order_relaxed);
+        }
+    }
+    const auto now = std::chrono::steady_clock::now();
+    const auto to_us = [](auto duration) {
+        return static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::microseconds>(duration).count());
+    };
+    if (dispatchers_.empty()) {
+        stats.dispatchers = 1;
+        stats.dispatcher_stats[0] = DispatcherStats{
+            inline_batches_.load(std::memory_order_relaxed),
+            inline_busy_ns_.load(std::memory_order_relaxed) / 1000, to_us(now - receive_started_)};
+    } else {
+        stats.dispatchers = static_cast<int>(dispatchers_.size());
+        for (size_t i = 0; i < dispatchers_.size(); i++) {
+            const Dispatcher& dispatcher = *dispatchers_[i];
+            stats.dispatcher_stats[i] = DispatcherStats{
+                dispatcher.batches.load(std::memory_order_relaxed),
+                dispatcher.busy_ns.load(std::memory_order_relaxed) / 1000,
+                to_us(now - dispatcher.started)};
+        }
+    }
+    {
+        std::shared_lock<std::shared_mutex> lock(map_mutex_);
+        stats.task_queues = task_queues_.size();
+    }
+    return stats;
 }
 
 void NetworkNode::Stop() {
     stop_flag_.store(true);
-    send_data_cv_.notify_one();
-    zmq::socket_t exit_sender(context_, ZMQ_PAIR);
-    exit_sender.connect("inproc://exit_" + std::to_string(node_id_));
-    std::string exit_msg = "exit";
-    exit_sender.send(zmq::message_t(exit_msg.data(), exit_msg.size()), zmq::send_flags::none);
+    for (auto& shard : shards_) {
+        shard->cv.notify_all();
+    }
+    for (auto& dispatcher : dispatchers_) {
+        std::lock_guard<std::mutex> lock(dispatcher->mutex);
+        dispatcher->cv.notify_all();
+    }
+    transport_->Interrupt();
+
+    // Nothing will serve the continuations any more. Destroying them outside the locks breaks
+    // the promises of future-based receives. Blocked receivers are woken so that they throw.
+    std::vector<PendingReceive> dropped;
+    {
+        std::shared_lock<std::shared_mutex> map_lock(map_mutex_);
+        for (auto& [task_id, queue] : task_queues_) {
+            std::lock_guard<std::mutex> lock(queue->mutex);
+            for (auto& [operation_id, op] : queue->operations) {
+                std::move(op.pending.begin(), op.pending.end(), std::back_inserter(dropped));
+                op.pending.clear();
+                op.cv.notify_all();
+            }
+        }
+    }
 }
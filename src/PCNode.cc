@@ -1,26 +1,18 @@
 #include "PCNode.h"
 
 Node::Node(const uint8_t id, const uint32_t share_count) : id_(id) {
-    std::vector<uint8_t> key(16, 1);
-    SetKey(key);
+    prf_.SetKey(std::vector<uint8_t>(Prf::kKeySize, 1).data());
     InitializeMaps(share_count);
     GenerateAllConditions();
     GenerateConditionMap();
 }
 
 void Node::SetKey(const std::vector<uint8_t> &key) {
-    if (AES_set_encrypt_key(key.data(), 128, &aes_key_) != 0) {
+    if (key.size() < Prf::kKeySize) {
         throw std::runtime_error("Failed to set AES key");
     }
-}
-
-uint64_t Node::PRFEval(const uint64_t input) const {
-    std::vector<uint8_t> input_block(AES_BLOCK_SIZE, 0);
-    *reinterpret_cast<uint64_t *>(input_block.data()) = input;
-
-    std::vector<uint8_t> output_block(AES_BLOCK_SIZE);
-    AES_encrypt(input_block.data(), output_block.data(), &aes_key_);
-    return *reinterpret_cast<uint64_t *>(output_block.data());
+    prf_.SetKey(key.data());
+    subset_keys_ = SubsetKeys::Derive(key.data());
 }
 
 void Node::InitializeMaps(const uint32_t count) {
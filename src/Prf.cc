@@ -0,0 +1,121 @@
+#include "Prf.h"
+
+#include <cstring>
+#include <stdexcept>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+
+namespace {
+
+constexpr size_t kLanes = 8;
+
+template <int kRcon>
+__attribute__((target("aes"))) __m128i ExpandRound(__m128i key) {
+    __m128i assist = _mm_shuffle_epi32(_mm_aeskeygenassist_si128(key, kRcon), 0xff);
+    key = _mm_xor_si128(key, _mm_slli_si128(key, 4));
+    key = _mm_xor_si128(key, _mm_slli_si128(key, 4));
+    key = _mm_xor_si128(key, _mm_slli_si128(key, 4));
+    return _mm_xor_si128(key, assist);
+}
+
+__attribute__((target("aes"))) void ExpandKey(const uint8_t *key, uint8_t (&round_keys)[11][16]) {
+    __m128i rk[11];
+    rk[0] = _mm_loadu_si128(reinterpret_cast<const __m128i *>(key));
+    rk[1] = ExpandRound<0x01>(rk[0]);
+    rk[2] = ExpandRound<0x02>(rk[1]);
+    rk[3] = ExpandRound<0x04>(rk[2]);
+    rk[4] = ExpandRound<0x08>(rk[3]);
+    rk[5] = ExpandRound<0x10>(rk[4]);
+    rk[6] = ExpandRound<0x20>(rk[5]);
+    rk[7] = ExpandRound<0x40>(rk[6]);
+    rk[8] = ExpandRound<0x80>(rk[7]);
+    rk[9] = ExpandRound<0x1b>(rk[8]);
+    rk[10] = ExpandRound<0x36>(rk[9]);
+    for (int round = 0; round <= 10; ++round) {
+        _mm_store_si128(reinterpret_cast<__m128i *>(round_keys[round]), rk[round]);
+    }
+}
+
+__attribute__((target("aes"))) void EncryptAesNi(const uint8_t (&round_keys)[11][16],
+                                                 uint64_t nonce, uint64_t first_counter,
+                                                 size_t count, uint64_t *out) {
+    __m128i rk[11];
+    for (int round = 0; round <= 10; ++round) {
+        rk[round] = _mm_load_si128(reinterpret_cast<const __m128i *>(round_keys[round]));
+    }
+
+    const auto high = static_cast<long long>(nonce);
+    size_t i = 0;
+    for (; i + kLanes <= count; i += kLanes) {
+        __m128i blocks[kLanes];
+        for (size_t lane = 0; lane < kLanes; ++lane) {
+            blocks[lane] = _mm_xor_si128(
+                _mm_set_epi64x(high, static_cast<long long>(first_counter + i + lane)), rk[0]);
+        }
+        for (int round = 1; round < 10; ++round) {
+            for (size_t lane = 0; lane < kLanes; ++lane) {
+                blocks[lane] = _mm_aesenc_si128(blocks[lane], rk[round]);
+            }
+        }
+        for (size_t lane = 0; lane < kLanes; ++lane) {
+            out[i + lane] = static_cast<uint64_t>(
+                _mm_cvtsi128_si64(_mm_aesenclast_si128(blocks[lane], rk[10])));
+        }
+    }
+    for (; i < count; ++i) {
+        __m128i block = _mm_xor_si128(
+            _mm_set_epi64x(high, static_cast<long long>(first_counter + i)), rk[0]);
+        for (int round = 1; round < 10; ++round) {
+            block = _mm_aesenc_si128(block, rk[round]);
+        }
+        out[i] = static_cast<uint64_t>(_mm_cvtsi128_si64(_mm_aesenclast_si128(block, rk[10])));
+    }
+}
+
+}  // namespace
+#endif
+
+void Prf::SetKey(const uint8_t *key) {
+    if (AES_set_encrypt_key(key, 128, &aes_key_) != 0) {
+        throw std::runtime_error("Failed to set AES key");
+    }
+#if defined(__x86_64__)
+    if (HasAesNi()) {
+        ExpandKey(key, round_keys_);
+    }
+#endif
+}
+
+void Prf::CtrBatch(const uint64_t nonce, const uint64_t first_counter, const size_t count,
+                   uint64_t *out) const {
+#if defined(__x86_64__)
+    if (HasAesNi()) {
+        EncryptAesNi(round_keys_, nonce, first_counter, count, out);
+        return;
+    }
+#endif
+    uint8_t input_block[AES_BLOCK_SIZE];
+    uint8_t output_block[AES_BLOCK_SIZE];
+    std::memcpy(input_block + sizeof(uint64_t), &nonce, sizeof(nonce));
+    for (size_t i = 0; i < count; ++i) {
+        const uint64_t counter = first_counter + i;
+        std::memcpy(input_block, &counter, sizeof(counter));
+        AES_encrypt(input_block, output_block, &aes_key_);
+        std::memcpy(&out[i], output_block, sizeof(out[i]));
+    }
+}
+
+bool Prf::HasAesNi() {
+    // Function-local so that Nodes constructed during static initialisation see the same answer
+    // in SetKey and CtrBatch.
+#if defined(__x86_64__)
+    static const bool has_aes_ni = [] {
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("aes") != 0;
+    }();
+    return has_aes_ni;
+#else
+    return false;
+#endif
+}
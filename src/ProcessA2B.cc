@@ -98,6 +98,7 @@ void SingleBitFullAdder::Handle(const std::vector<uint8_t>& data, Node& node,
 
 void A2BOffProtocol::Handle(const std::vector<uint8_t>& data, Node& node, NetworkNode& network_node,
                             TaskContext& ctx) {
+    const TrafficClassScope bulk(TrafficClass::kBulk);
     auto target_id = bytesToUint16(data[1], data[2]);
     auto start_id = data[3];
     auto bit_key = data[4];
@@ -7,6 +7,7 @@
 
 void TrunOffProtocol::Handle(const std::vector<uint8_t> &data, Node &node,
                              NetworkNode &network_node, TaskContext &ctx) {
+    const TrafficClassScope bulk(TrafficClass::kBulk);
     uint8_t r_key = data[1];
     uint32_t start_id = readUint32(data, 2);
 
@@ -138,3 +139,36 @@ void TrunOnProtocol::Handle(const std::vector<uint8_t> &data, Node &node, Networ
     auto trun_on_recovery_proto = new TrunOnRecoveryProtocol();
     trun_on_recovery_proto->Handle(recovery_msg, node);
 }
+
+ProtocolTask<> TrunOnProtocol::HandleAsync(std::vector<uint8_t> data, Node &node,
+                                           NetworkNode &network_node, TaskContext &ctx) {
+    const uint8_t input_id = data[1];
+    const uint8_t r_key = data[2];
+    const uint8_t result_id = data[3];
+
+    // Messages are built as named vectors: GCC 12 rejects braced temporaries in coroutines.
+    const std::vector<uint8_t> trun_msg = {ProtocolType::TRUN_ON_PREPARE, input_id, r_key,
+                                           result_id};
+    TrunOnPrepareProtocol::Handle(trun_msg, node);
+
+    // Same reconstruction rounds as Handle(): senders 3,4,5 to parties 1 and 2, 2,4,5 to 3.
+    std::vector<uint8_t> rec_msg = {ProtocolType::REC, 3, 4, 5, 0, result_id};
+    for (uint8_t id = 1; id <= 3; ++id) {
+        rec_msg[1] = id == 3 ? 2 : 3;
+        rec_msg[4] = id;
+        co_await ReconstructionProtocol::HandleAsync(rec_msg, node, network_node, ctx);
+        ctx.operation_id++;
+    }
+
+    const std::vector<uint8_t> shift_msg = {ProtocolType::RIGHT_SHIFT, 1, 2, 3, result_id};
+    RightShiftProtocol::Handle(shift_msg, node);
+
+    std::vector<uint8_t> joint_share_msg = {ProtocolType::JOINT_SHARE_BETA_OFF, 1, 2, 3, 4, 5};
+    JointSharingBetaOfflineProtocol::Handle(joint_share_msg, node);
+    joint_share_msg[0] = ProtocolType::JOINT_SHARE_BETA;
+    co_await JointSharingBetaProtocol::HandleAsync(joint_share_msg, node, network_node, ctx);
+    ctx.operation_id++;
+
+    const std::vector<uint8_t> recovery_msg = {ProtocolType::TRUN_ON_RECOVERY, r_key, result_id};
+    TrunOnRecoveryProtocol::Handle(recovery_msg, node);
+}
@@ -3,12 +3,14 @@
 
 void ReSharingOfflineProtocol::Handle(const std::vector<uint8_t> &data, Node &node) {
     const uint8_t node_id = node.ID();
+    const uint64_t counter = node.ReserveCounters(RandomDomain::kReSharing, 4);
     if (node_id != data[5]) {
+        uint64_t reshares[4];
+        node.SubsetRandom(AllPartiesExcept(data[5]), counter, 4, reshares);
         uint64_t sum = 0;
         for (uint8_t i = 1; i <= 4; ++i) {
-            const uint64_t reshare = node.PRFEval(i);
-            node.SetReshare(reshare, i - 1);
-            sum += reshare;
+            node.SetReshare(reshares[i - 1], i - 1);
+            sum += reshares[i - 1];
         }
         node.SetReshare(std::numeric_limits<uint64_t>::max() - sum + 1, 4);
         // SPDLOG_INFO("Node {} Reshare {}", node_id, fmt::join(node.GetFullReshare(), ", "));
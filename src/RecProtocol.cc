@@ -13,14 +13,31 @@ void ReconstructionProtocol::Handle(const std::vector<uint8_t> &data, Node &node
         jMPProtocol.Handle(data, node, network_node, ctx);
     } else if (node_id == data[4]) {
         jMPProtocol.Handle(data, node, network_node, ctx);
-        beta_share.SetAlpha(node.T(), data[4]);
-        if (data[0] == ProtocolType::REC) {
-            if (beta_share.Beta() < beta_share.AlphaSum()) {
-                node.SetTruncationWrap(true);
-            }
-            node.SetValues(data[5], beta_share.Beta() - beta_share.AlphaSum());
-        } else if (data[0] == ProtocolType::BIT_REC) {
-            node.SetValues(data[5], beta_share.Beta() ^ beta_share.AlphaXor());
+        Reconstruct(data, node);
+    }
+}
+
+ProtocolTask<> ReconstructionProtocol::HandleAsync(std::vector<uint8_t> data, Node &node,
+                                                   NetworkNode &network_node, TaskContext ctx) {
+    const uint8_t node_id = node.ID();
+    if (node_id == data[1] || node_id == data[2] || node_id == data[3]) {
+        node.SetT(node.BetaShares(data[5]).Alpha(data[4]));
+        co_await JMPProtocol::HandleAsync(data, node, network_node, ctx);
+    } else if (node_id == data[4]) {
+        co_await JMPProtocol::HandleAsync(data, node, network_node, ctx);
+        Reconstruct(data, node);
+    }
+}
+
+void ReconstructionProtocol::Reconstruct(const std::vector<uint8_t> &data, Node &node) {
+    CipherData &beta_share = node.BetaShares(data[5]);
+    beta_share.SetAlpha(node.T(), data[4]);
+    if (data[0] == ProtocolType::REC) {
+        if (beta_share.Beta() < beta_share.AlphaSum()) {
+            node.SetTruncationWrap(true);
         }
+        node.SetValues(data[5], beta_share.Beta() - beta_share.AlphaSum());
+    } else if (data[0] == ProtocolType::BIT_REC) {
+        node.SetValues(data[5], beta_share.Beta() ^ beta_share.AlphaXor());
     }
 }
@@ -8,12 +8,16 @@ void SharingBetaOfflineProtocol::Handle(const std::vector<uint8_t> &data, Node &
     const uint32_t idx = readUint32(data, 6);
     CipherData &beta_share = node.BetaShares(idx, true);
     const uint8_t node_id = node.ID();
+    // Keyed by share id rather than reserved, so parties may share values in any order.
+    const uint64_t counter = RandomCounter(RandomDomain::kSharing, 5 * uint64_t{idx});
     for (uint8_t id = 1; id <= 5; ++id) {
         if (node_id != data[1] && id == node_id) {
             beta_share.SetAlpha(0, id);
             continue;
         }
-        uint64_t alpha_share = node.PRFEval(id + 5 * idx);
+        // [[alpha]]_id is known to every party but id, unless id is the dealer.
+        const PartySet holders = id == data[1] ? kAllParties : AllPartiesExcept(id);
+        uint64_t alpha_share = node.SubsetRandom(holders, counter + id - 1);
         if (data[0] == ProtocolType::BIT_SHARE_BETA_OFF) {
             alpha_share &= 1;
         }
@@ -40,7 +44,12 @@ void SharingBetaProtocol::Handle(const std::vector<uint8_t> &data, Node &node,
         beta_share.SetBeta(beta);
 
         for (int index = 2; index <= 5; ++index) {
-            network_node.AddMessage(data[index], ctx.task_id, ctx.operation_id, beta_share.Beta());
+            if (data[0] == ProtocolType::BIT_SHARE_BETA) {
+                network_node.AddBit(data[index], ctx.task_id, ctx.operation_id, beta_share.Beta());
+            } else {
+                network_node.AddMessage(data[index], ctx.task_id, ctx.operation_id,
+                                        beta_share.Beta());
+            }
         }
     } else if (node_id == data[2] || node_id == data[3] || node_id == data[4] ||
                node_id == data[5]) {
@@ -53,14 +62,26 @@ void SharingBetaProtocol::Handle(const std::vector<uint8_t> &data, Node &node,
     }
 }
 
+namespace {
+
+// Holders of share id in a joint sharing by data[1..3]: every party but id, unless id is one of
+// the three owners.
+PartySet JointHolders(const std::vector<uint8_t> &data, const uint8_t id) {
+    const bool owner = id == data[1] || id == data[2] || id == data[3];
+    return owner ? kAllParties : AllPartiesExcept(id);
+}
+
+}  // namespace
+
 void JointSharingBetaOfflineProtocol::Handle(const std::vector<uint8_t> &data, Node &node) {
     const uint8_t node_id = node.ID();
+    const uint64_t counter = node.ReserveCounters(RandomDomain::kJointSharingBeta, 5);
     for (uint8_t id = 1; id <= 5; ++id) {
         if (node_id != data[1] && node_id != data[2] && node_id != data[3] && id == node_id) {
             node.SetAlpha(0, id);
             continue;
         }
-        const uint64_t alpha_share = node.PRFEval(id);
+        const uint64_t alpha_share = node.SubsetRandom(JointHolders(data, id), counter + id - 1);
         node.SetAlpha(alpha_share, id);
     }
 }
@@ -83,8 +104,23 @@ void JointSharingBetaProtocol::Handle(const std::vector<uint8_t> &data, Node &no
     }
 }
 
+ProtocolTask<> JointSharingBetaProtocol::HandleAsync(std::vector<uint8_t> data, Node &node,
+                                                     NetworkNode &network_node, TaskContext ctx) {
+    const uint8_t node_id = node.ID();
+
+    if (node_id == data[1] || node_id == data[2] || node_id == data[3]) {
+        node.SetBeta(node.AlphaSum() + node.Val());
+        for (std::size_t index = 4; index <= 5; ++index) {
+            network_node.AddMessage(data[index], ctx.task_id, ctx.operation_id, node.Beta());
+        }
+    } else if (node_id == data[4] || node_id == data[5]) {
+        node.SetBeta(co_await CoReceive(network_node, ctx.task_id, ctx.operation_id, 3));
+    }
+}
+
 void JointSharingOfflineProtocol::Handle(const std::vector<uint8_t> &data, Node &node) {
     const uint8_t node_id = node.ID();
+    const uint64_t counter = node.ReserveCounters(RandomDomain::kJointSharing, 5);
     for (uint8_t id = 1; id <= 5; ++id) {
         if (id == data[5]) {
             node.SetShare(0, id - 1);
@@ -94,7 +130,7 @@ void JointSharingOfflineProtocol::Handle(const std::vector<uint8_t> &data, Node
             node.SetShare(0, id - 1);
             continue;
         }
-        const uint64_t x_share = node.PRFEval(id);
+        const uint64_t x_share = node.SubsetRandom(JointHolders(data, id), counter + id - 1);
         node.SetShare(x_share, id - 1);
     }
     // SPDLOG_INFO("Node {} Share {}", node_id, fmt::join(node.GetFullShare(), ", "));
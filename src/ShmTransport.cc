@@ -0,0 +1,307 @@
+#include "ShmTransport.h"
+
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <thread>
+
+#include "WireFormat.h"
+
+struct ShmTransport::Ring {
+    alignas(64) std::atomic<uint64_t> head;  // bytes published by the sender
+    alignas(64) std::atomic<uint64_t> tail;  // bytes released by the receiver
+};
+
+struct ShmTransport::Segment {
+    std::atomic<uint32_t> ready;
+    // Set by a restarted owner before it replaces the segment; senders then re-open its inbox.
+    std::atomic<uint32_t> retired;
+    pid_t creator;
+    uint32_t ring_bytes;
+    Ring rings[6];  // indexed by sender id
+
+    static size_t Size(size_t ring_bytes) {
+        return sizeof(Segment) + 6 * ring_bytes;
+    }
+
+    uint8_t *Data(int sender_id) {
+        return reinterpret_cast<uint8_t *>(this + 1) + sender_id * static_cast<size_t>(ring_bytes);
+    }
+};
+
+namespace {
+
+constexpr size_t kLengthSize = sizeof(uint64_t);
+
+std::string ShmName(const std::string &address) {
+    const std::string scheme = "shm://";
+    if (address.rfind(scheme, 0) != 0) {
+        throw std::invalid_argument("Not a shm:// address: " + address);
+    }
+    return "/" + address.substr(scheme.size());
+}
+
+void Backoff(int &idle) {
+    if (++idle < 64) {
+        std::this_thread::yield();
+    } else {
+        std::this_thread::sleep_for(std::chrono::microseconds(50));
+    }
+}
+
+// Copies between a linear buffer and a ring position, splitting at the wrap point.
+void CopyIn(uint8_t *ring, size_t ring_bytes, uint64_t pos, const uint8_t *src, size_t size) {
+    const size_t offset = pos % ring_bytes;
+    const size_t first = std::min(size, ring_bytes - offset);
+    std::memcpy(ring + offset, src, first);
+    std::memcpy(ring, src + first, size - first);
+}
+
+void CopyOut(const uint8_t *ring, size_t ring_bytes, uint64_t pos, uint8_t *dst, size_t size) {
+    const size_t offset = pos % ring_bytes;
+    const size_t first = std::min(size, ring_bytes - offset);
+    std::memcpy(dst, ring + offset, first);
+    std::memcpy(dst + first, ring, size - first);
+}
+
+bool Alive(pid_t pid) {
+    return kill(pid, 0) == 0 || errno == EPERM;
+}
+
+}  // namespace
+
+ShmTransport::ShmTransport(int node_id, const std::unordered_map<int, std::string> &addresses,
+                           size_t ring_bytes)
+    : node_id_(node_id), ring_bytes_(ring_bytes) {
+    if (ring_bytes_ < 64 || ring_bytes_ % kLengthSize != 0) {
+        throw std::invalid_argument("ring_bytes must be a multiple of 8 and at least 64");
+    }
+    inbox_name_ = ShmName(addresses.at(node_id_));
+    inbox_ = Map(inbox_name_, ring_bytes_, true);
+    for (int peer_id = 1; peer_id <= 5; peer_id++) {
+        if (peer_id != node_id_) {
+            peer_names_[peer_id] = ShmName(addresses.at(peer_id));
+        }
+    }
+}
+
+ShmTransport::~ShmTransport() {
+    for (Segment *peer : peers_) {
+        if (peer != nullptr) {
+            munmap(peer, Segment::Size(ring_bytes_));
+        }
+    }
+    munmap(inbox_, Segment::Size(ring_bytes_));
+    shm_unlink(inbox_name_.c_str());
+}
+
+ShmTransport::Segment *ShmTransport::Map(const std::string &name, size_t ring_bytes,
+                                         bool create) {
+    const size_t size = Segment::Size(ring_bytes);
+    int fd;
+    if (create) {
+        // A segment left behind by a crashed run would hold stale ring positions, and peers
+        // that mapped it before we started would keep writing into it. Retire it first.
+        fd = shm_open(name.c_str(), O_RDWR, 0600);
+        if (fd >= 0) {
+            struct stat st {};
+            if (fstat(fd, &st) == 0 && static_cast<size_t>(st.st_size) >= sizeof(Segment)) {
+                void *stale = mmap(nullptr, sizeof(Segment), PROT_READ | PROT_WRITE, MAP_SHARED,
+                                   fd, 0);
+                if (stale != MAP_FAILED) {
+                    static_cast<Segment *>(stale)->retired.store(1, std::memory_order_release);
+                    munmap(stale, sizeof(Segment));
+                }
+            }
+            close(fd);
+        }
+        shm_unlink(name.c_str());
+        fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+        if (fd < 0 || ftruncate(fd, static_cast<off_t>(size)) != 0) {
+            throw std::runtime_error("Cannot create shared memory segment " + name + ": " +
+                                     std::strerror(errno));
+        }
+    } else {
+        fd = shm_open(name.c_str(), O_RDWR, 0600);
+        struct stat st {};
+        if (fd < 0) {
+            return nullptr;
+        }
+        if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < size) {
+            close(fd);
+            return nullptr;
+        }
+    }
+
+    void *addr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (addr == MAP_FAILED) {
+        throw std::runtime_error("Cannot map shared memory segment " + name);
+    }
+
+    auto *segment = static_cast<Segment *>(addr);
+    if (create) {
+        // ftruncate zero-fills, so the ring counters already start at 0.
+        segment->ring_bytes = static_cast<uint32_t>(ring_bytes);
+        segment->creator = getpid();
+        segment->ready.store(1, std::memory_order_release);
+    } else if (segment->ready.load(std::memory_order_acquire) == 0 ||
+               segment->retired.load(std::memory_order_acquire) != 0 ||
+               !Alive(segment->creator)) {
+        // Not set up yet, or left behind by an earlier run: wait for the peer's own inbox.
+        munmap(addr, size);
+        return nullptr;
+    } else if (segment->ring_bytes != ring_bytes) {
+        munmap(addr, size);
+        throw std::runtime_error("Ring size mismatch with peer segment " + name);
+    }
+    return segment;
+}
+
+ShmTransport::Segment *ShmTransport::PeerSegment(int peer_id) {
+    // The peer may not have started yet; like a ZeroMQ connect, wait until its inbox exists.
+    while (peers_.at(peer_id) == nullptr && !interrupted_.load()) {
+        peers_[peer_id] = Map(peer_names_.at(peer_id), ring_bytes_, false);
+        if (peers_[peer_id] == nullptr) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+    return peers_[peer_id];
+}
+
+void ShmTransport::Send(int peer_id, PooledBuffer *batch) {
+    for (;;) {
+        Segment *peer = PeerSegment(peer_id);
+        if (peer == nullptr || Write(*peer, *batch)) {
+            break;
+        }
+        // The peer restarted and retired the inbox we had mapped; whatever went into it is lost
+        // with it, so the whole batch goes again into the new one.
+        munmap(peer, Segment::Size(ring_bytes_));
+        peers_[peer_id] = nullptr;
+    }
+    BufferPool::Release(batch->bytes.data(), batch);
+}
+
+bool ShmTransport::Write(Segment &peer, const PooledBuffer &batch) {
+    if (peer.retired.load(std::memory_order_acquire) != 0) {
+        return false;
+    }
+    Ring &ring = peer.rings[node_id_];
+    uint8_t *data = peer.Data(node_id_);
+
+    uint8_t length[kLengthSize];
+    StoreLE64(length, batch.bytes.size());
+    const uint8_t *parts[2] = {length, batch.bytes.data()};
+    const size_t sizes[2] = {kLengthSize, batch.bytes.size()};
+
+    uint64_t head = ring.head.load(std::memory_order_relaxed);
+    int idle = 0;
+    for (int part = 0; part < 2; ++part) {
+        size_t written = 0;
+        while (written < sizes[part]) {
+            const uint64_t tail = ring.tail.load(std::memory_order_acquire);
+            const size_t free = ring_bytes_ - static_cast<size_t>(head - tail);
+            if (free == 0) {
+                if (interrupted_.load()) {
+                    return true;
+                }
+                if (peer.retired.load(std::memory_order_acquire) != 0) {
+                    return false;
+                }
+                Backoff(idle);
+                continue;
+            }
+            idle = 0;
+            const size_t chunk = std::min(free, sizes[part] - written);
+            CopyIn(data, ring_bytes_, head, parts[part] + written, chunk);
+            head += chunk;
+            written += chunk;
+            ring.head.store(head, std::memory_order_release);
+        }
+    }
+    // Retirement may have raced with a write that never had to wait; the retiring owner sets the
+    // flag before it unlinks, so a batch that lands in a retired segment is sent again.
+    return peer.retired.load(std::memory_order_acquire) == 0;
+}
+
+bool ShmTransport::ReadReady(int sender_id, const BatchHandler &on_batch) {
+    Ring &ring = inbox_->rings[sender_id];
+    const uint8_t *data = inbox_->Data(sender_id);
+    InboundState &state = inbound_[sender_id];
+
+    const uint64_t head = ring.head.load(std::memory_order_acquire);
+    uint64_t tail = ring.tail.load(std::memory_order_relaxed);
+    size_t available = static_cast<size_t>(head - tail);
+
+    if (!state.has_length) {
+        if (available < kLengthSize) {
+            return false;
+        }
+        uint8_t length[kLengthSize];
+        CopyOut(data, ring_bytes_, tail, length, kLengthSize);
+        const size_t size = LoadLE64(length);
+        const size_t offset = (tail + kLengthSize) % ring_bytes_;
+
+        // Common case: the whole batch is already there without wrapping, parse it in place.
+        if (available - kLengthSize >= size && offset + size <= ring_bytes_) {
+            on_batch(data + offset, size);
+            ring.tail.store(tail + kLengthSize + size, std::memory_order_release);
+            return true;
+        }
+
+        tail += kLengthSize;
+        available -= kLengthSize;
+        state.expected = size;
+        state.has_length = true;
+        state.batch.clear();
+    }
+
+    const size_t chunk = std::min(available, state.expected - state.batch.size());
+    const size_t filled = state.batch.size();
+    state.batch.resize(filled + chunk);
+    CopyOut(data, ring_bytes_, tail, state.batch.data() + filled, chunk);
+    ring.tail.store(tail + chunk, std::memory_order_release);
+
+    if (state.batch.size() < state.expected) {
+        return false;
+    }
+    state.has_length = false;
+    on_batch(state.batch.data(), state.batch.size());
+    return true;
+}
+
+bool ShmTransport::Poll(std::chrono::milliseconds timeout, const BatchHandler &on_batch) {
+    const auto deadline = std::chrono::steady_clock::now() + timeout;
+    int idle = 0;
+    for (;;) {
+        bool delivered = false;
+        for (int sender_id = 1; sender_id <= 5; sender_id++) {
+            if (sender_id == node_id_) {
+                continue;
+            }
+            while (ReadReady(sender_id, on_batch)) {
+                delivered = true;
+            }
+        }
+        if (delivered) {
+            return true;
+        }
+        if (interrupted_.load() || timeout.count() == 0 ||
+            (timeout.count() > 0 && std::chrono::steady_clock::now() >= deadline)) {
+            return false;
+        }
+        Backoff(idle);
+    }
+}
+
+void ShmTransport::Interrupt() {
+    interrupted_.store(true);
+}
@@ -0,0 +1,42 @@
+#include "SubsetKeys.h"
+
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+std::shared_ptr<const SubsetKeys> SubsetKeys::Derive(const uint8_t *master_key) {
+    Prf master;
+    master.SetKey(master_key);
+    auto keys = std::make_shared<SubsetKeys>();
+    for (PartySet subset = 1; subset <= kAllParties; ++subset) {
+        uint64_t words[2];
+        master.EvalBatch(2 * static_cast<uint64_t>(subset), 2, words);
+        uint8_t key[Prf::kKeySize];
+        std::memcpy(key, words, sizeof(key));
+        keys->SetKey(subset, key);
+    }
+    return keys;
+}
+
+const std::shared_ptr<const SubsetKeys> &SubsetKeys::Default() {
+    static const std::shared_ptr<const SubsetKeys> keys =
+        Derive(std::vector<uint8_t>(Prf::kKeySize, 1).data());
+    return keys;
+}
+
+void SubsetKeys::SetKey(const PartySet subset, const uint8_t *key) {
+    if (subset == 0 || subset > kAllParties) {
+        throw std::invalid_argument("Invalid party subset: " + std::to_string(subset));
+    }
+    prfs_[subset].SetKey(key);
+    present_ |= uint32_t{1} << subset;
+}
+
+void SubsetKeys::Generate(const PartySet subset, const uint64_t nonce,
+                          const uint64_t first_counter, const size_t count, uint64_t *out) const {
+    if (subset >= kSubsetCount || !Has(subset)) {
+        throw std::runtime_error("No PRF key for party subset: " + std::to_string(subset));
+    }
+    prfs_[subset].CtrBatch(nonce, first_counter, count, out);
+}
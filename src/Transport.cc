@@ -0,0 +1,37 @@
+#include "Transport.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+#include "ShmTransport.h"
+#include "ZmqTransport.h"
+
+std::unique_ptr<Transport> MakeTransport(int node_id, int io_threads,
+                                         const std::unordered_map<int, std::string> &addresses) {
+    const bool shm = std::all_of(addresses.begin(), addresses.end(), [](const auto &entry) {
+        return entry.second.rfind("shm://", 0) == 0;
+    });
+    if (shm) {
+        return std::make_unique<ShmTransport>(node_id, addresses);
+    }
+    return std::make_unique<ZmqTransport>(node_id, io_threads, addresses);
+}
+
+std::unordered_map<int, std::string> LocalNodeAddresses(const std::string &scheme) {
+    std::unordered_map<int, std::string> addresses;
+    for (int node_id = 1; node_id <= 5; node_id++) {
+        const std::string id = std::to_string(node_id);
+        if (scheme == "tcp") {
+            addresses[node_id] = "tcp://127.0.0.1:555" + id;
+        } else if (scheme == "ipc") {
+            addresses[node_id] = "ipc:///tmp/mpc_node_" + id;
+        } else if (scheme == "inproc") {
+            addresses[node_id] = "inproc://mpc_node_" + id;
+        } else if (scheme == "shm") {
+            addresses[node_id] = "shm://mpc_node_" + id;
+        } else {
+            throw std::invalid_argument("Unknown transport scheme: " + scheme);
+        }
+    }
+    return addresses;
+}
@@ -1,5 +1,6 @@
 #include <bitset>
 
+#include "CipherVector.h"
 #include "TruncationProtocol.h"
 
 void TrunOffPrepareProtocol::Handle(const std::vector<uint8_t>& data, Node& node) {
@@ -11,13 +12,13 @@ void TrunOffPrepareProtocol::Handle(const std::vector<uint8_t>& data, Node& node
                                                                    {data[3], {1, 2}},
                                                                    {data[4], {1, 2, 3}},
                                                                    {data[5], {1, 2, 3}}};
+    const uint64_t counter = node.ReserveCounters(RandomDomain::kTruncation, 3);
     const auto it = share_mapping.find(node_id);
     if (it != share_mapping.end()) {
+        // r_j's share is known to every party but data[j].
         std::array<uint64_t, 3> shares{0, 0, 0};
-        for (uint8_t i = 1; i <= 3; ++i) {
-            if (i != node_id) {
-                shares[i - 1] = node.PRFEval(start_id * 3 + i);
-            }
+        for (const unsigned char j : it->second) {
+            shares[j - 1] = node.SubsetRandom(AllPartiesExcept(data[j]), counter + j - 1);
         }
 
         for (const unsigned char j : it->second) {
@@ -71,50 +72,35 @@ void LinearCombineProtocol::Handle(const std::vector<uint8_t>& data, Node& node)
     const uint32_t start_id = readUint32(data, 1);
     const uint8_t truncated_bit = data[5];
     const uint8_t key = data[6];
-    std::vector<std::array<uint64_t, 5>> r_vec;
-
-    for (uint16_t bit_pos = 0; bit_pos < 64; ++bit_pos) {
-        std::array<uint64_t, 5> cipher_r1 =
-            Node::BetaToAdditive(node.BetaShares(start_id + bit_pos * 3), node_id);
-        std::array<uint64_t, 5> cipher_r2 =
-            Node::BetaToAdditive(node.BetaShares(start_id + bit_pos * 3 + 1), node_id);
-        std::array<uint64_t, 5> cipher_r3 =
-            Node::BetaToAdditive(node.BetaShares(start_id + bit_pos * 3 + 2), node_id);
-        std::array<uint64_t, 5> cipher_r12 =
-            Node::BetaToAdditive(node.BetaShares(start_id + 192 + bit_pos * 3), node_id);
-        std::array<uint64_t, 5> cipher_r23 =
-            Node::BetaToAdditive(node.BetaShares(start_id + 192 + bit_pos * 3 + 1), node_id);
-        std::array<uint64_t, 5> cipher_r13 =
-            Node::BetaToAdditive(node.BetaShares(start_id + 192 + bit_pos * 3 + 2), node_id);
-        std::array<uint64_t, 5> cipher_r123 =
-            Node::BetaToAdditive(node.BetaShares(start_id + 384 + bit_pos), node_id);
 
-        // r[t] = ∑(ri[t]) - ∑2(ri[t]*rj[t]) + 4(r1[t]*r2[t]*r3[t])
-        std::array<uint64_t, 5> r_bit = {};
-        for (uint8_t id = 0; id < 5; ++id) {
-            if (id != node_id - 1) {
-                r_bit[id] = cipher_r1[id] + cipher_r2[id] + cipher_r3[id] -
-                            2 * (cipher_r12[id] + cipher_r23[id] + cipher_r13[id]) +
-                            4 * cipher_r123[id];
-            }
-        }
-        r_vec.push_back(r_bit);
-    }
+    // Shares start_id .. start_id + 447 hold, per bit t, r1 r2 r3 at 3t, the pairwise products
+    // r1r2 r2r3 r1r3 at 192 + 3t and r1r2r3 at 384 + t.
+    const CipherVector bits = CipherVector::Load(node, start_id, 448);
+    alignas(CipherVector::kAlignment) uint64_t additive[448];
 
     std::array<uint64_t, 5> r_full = {};
-    for (size_t t = 0; t < 64; ++t) {
-        for (uint8_t id = 0; id < 5; ++id) {
-            if (id != node_id - 1) {
-                r_full[id] += r_vec[t][id] * (1ULL << t);
-            }
+    std::array<uint64_t, 5> r_truncated = {};
+    for (uint8_t id = 0; id < 5; ++id) {
+        if (id == node_id - 1) {
+            continue;
+        }
+        // Column id of BetaToAdditive() for all 448 shares.
+        const uint64_t* alpha = bits.Alpha(id + 1);
+        const uint64_t* beta = bits.Beta();
+        for (size_t i = 0; i < 448; ++i) {
+            additive[i] = (id == 0 ? beta[i] : 0) - alpha[i];
         }
-    }
 
-    std::array<uint64_t, 5> r_truncated = {};
-    for (size_t t = truncated_bit; t < 64; ++t) {
-        for (uint8_t id = 0; id < 5; ++id) {
-            if (id != node_id - 1) {
-                r_truncated[id] += r_vec[t][id] * (1ULL << (t - truncated_bit));
+        // r[t] = ∑(ri[t]) - ∑2(ri[t]*rj[t]) + 4(r1[t]*r2[t]*r3[t])
+        for (size_t t = 0; t < 64; ++t) {
+            const uint64_t r_bit =
+                additive[3 * t] + additive[3 * t + 1] + additive[3 * t + 2] -
+                2 * (additive[192 + 3 * t] + additive[192 + 3 * t + 1] +
+                     additive[192 + 3 * t + 2]) +
+                4 * additive[384 + t];
+            r_full[id] += r_bit * (1ULL << t);
+            if (t >= truncated_bit) {
+                r_truncated[id] += r_bit * (1ULL << (t - truncated_bit));
             }
         }
     }
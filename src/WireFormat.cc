@@ -0,0 +1,106 @@
+#include "WireFormat.h"
+
+void FrameWriter::Reset(const int sender_id) {
+    buffer_.resize(kBatchHeaderSize);
+    StoreLE32(buffer_.data(), static_cast<uint32_t>(sender_id));
+    last_frame_ = 0;
+}
+
+uint8_t *FrameWriter::OpenFrame(const int task_id, const int operation_id, const size_t count) {
+    if (last_frame_ != 0 && !last_frame_bits_ && last_task_id_ == task_id &&
+        last_operation_id_ == operation_id) {
+        uint8_t *header = buffer_.data() + last_frame_;
+        StoreLE32(header + 8, LoadLE32(header + 8) + static_cast<uint32_t>(count));
+        const size_t offset = buffer_.size();
+        buffer_.resize(offset + count * sizeof(uint64_t));
+        return buffer_.data() + offset;
+    }
+
+    last_frame_ = buffer_.size();
+    last_task_id_ = task_id;
+    last_operation_id_ = operation_id;
+    last_frame_bits_ = false;
+    buffer_.resize(last_frame_ + kFrameHeaderSize + count * sizeof(uint64_t));
+    uint8_t *header = buffer_.data() + last_frame_;
+    StoreLE32(header, static_cast<uint32_t>(task_id));
+    StoreLE32(header + 4, static_cast<uint32_t>(operation_id));
+    StoreLE32(header + 8, static_cast<uint32_t>(count));
+    return header + kFrameHeaderSize;
+}
+
+void FrameWriter::Append(const int task_id, const int operation_id, const uint64_t value) {
+    StoreLE64(OpenFrame(task_id, operation_id, 1), value);
+}
+
+void FrameWriter::Append(const int task_id, const int operation_id, const uint64_t *values,
+                         const size_t count) {
+    uint8_t *dst = OpenFrame(task_id, operation_id, count);
+    for (size_t i = 0; i < count; ++i) {
+        StoreLE64(dst + i * sizeof(uint64_t), values[i]);
+    }
+}
+
+void FrameWriter::AppendBits(const int task_id, const int operation_id, const uint64_t *bits,
+                             const size_t count) {
+    uint32_t filled = 0;
+    if (last_frame_ != 0 && last_frame_bits_ && last_task_id_ == task_id &&
+        last_operation_id_ == operation_id) {
+        filled = LoadLE32(buffer_.data() + last_frame_ + 8) & ~kBitFrameFlag;
+    } else {
+        last_frame_ = buffer_.size();
+        last_task_id_ = task_id;
+        last_operation_id_ = operation_id;
+        last_frame_bits_ = true;
+        buffer_.resize(last_frame_ + kFrameHeaderSize);
+        uint8_t *header = buffer_.data() + last_frame_;
+        StoreLE32(header, static_cast<uint32_t>(task_id));
+        StoreLE32(header + 4, static_cast<uint32_t>(operation_id));
+    }
+
+    const uint32_t total = filled + static_cast<uint32_t>(count);
+    buffer_.resize(last_frame_ + kFrameHeaderSize + (total + 7) / 8);
+    uint8_t *payload = buffer_.data() + last_frame_ + kFrameHeaderSize;
+    for (size_t i = 0; i < count; ++i) {
+        const uint32_t index = filled + static_cast<uint32_t>(i);
+        const uint8_t mask = static_cast<uint8_t>(1U << (index % 8));
+        if (bits[i] & 1U) {
+            payload[index / 8] |= mask;
+        } else {
+            payload[index / 8] &= static_cast<uint8_t>(~mask);
+        }
+    }
+    StoreLE32(buffer_.data() + last_frame_ + 8, total | kBitFrameFlag);
+}
+
+FrameReader::FrameReader(const void *data, const size_t size)
+    : data_(static_cast<const uint8_t *>(data)), size_(size) {
+    if (size_ >= kBatchHeaderSize) {
+        sender_id_ = static_cast<int>(LoadLE32(data_));
+        valid_ = true;
+    }
+}
+
+bool FrameReader::Next(FrameView &frame) {
+    if (!valid_ || pos_ + kFrameHeaderSize > size_) {
+        return false;
+    }
+    const uint8_t *header = data_ + pos_;
+    const uint32_t count_field = LoadLE32(header + 8);
+    const bool bits = (count_field & kBitFrameFlag) != 0;
+    const uint32_t count = count_field & ~kBitFrameFlag;
+    const size_t payload_size = bits ? (static_cast<size_t>(count) + 7) / 8
+                                     : static_cast<size_t>(count) * sizeof(uint64_t);
+    const size_t frame_size = kFrameHeaderSize + payload_size;
+    if (pos_ + frame_size > size_) {
+        valid_ = false;
+        return false;
+    }
+
+    frame.task_id = static_cast<int>(LoadLE32(header));
+    frame.operation_id = static_cast<int>(LoadLE32(header + 4));
+    frame.count = count;
+    frame.bits = bits;
+    frame.values = header + kFrameHeaderSize;
+    pos_ += frame_size;
+    return true;
+}
@@ -0,0 +1,80 @@
+#include "ZmqTransport.h"
+
+#include <algorithm>
+#include <iostream>
+#include <sstream>
+
+namespace {
+
+bool AllInproc(const std::unordered_map<int, std::string> &addresses) {
+    return std::all_of(addresses.begin(), addresses.end(),
+                       [](const auto &entry) { return entry.second.rfind("inproc://", 0) == 0; });
+}
+
+}  // namespace
+
+zmq::context_t &ZmqTransport::SharedContext() {
+    static zmq::context_t context(1);
+    return context;
+}
+
+ZmqTransport::ZmqTransport(int node_id, int io_threads,
+                           const std::unordered_map<int, std::string> &addresses)
+    : node_id_(node_id),
+      own_context_(AllInproc(addresses) ? nullptr : std::make_unique<zmq::context_t>(io_threads)),
+      context_(own_context_ ? *own_context_ : SharedContext()),
+      router_(context_, ZMQ_ROUTER),
+      exit_pair_(context_, ZMQ_PAIR) {
+    router_.bind(addresses.at(node_id_));
+
+    // Several nodes may share a context, so the exit endpoint has to be unique per transport.
+    std::ostringstream exit_address;
+    exit_address << "inproc://exit_" << node_id_ << "_" << this;
+    exit_address_ = exit_address.str();
+    exit_pair_.bind(exit_address_);
+
+    for (int peer_id = 1; peer_id <= 5; peer_id++) {
+        if (peer_id != node_id_) {
+            dealers_.emplace(std::piecewise_construct, std::forward_as_tuple(peer_id),
+                             std::forward_as_tuple(context_, ZMQ_DEALER));
+            dealers_[peer_id].connect(addresses.at(peer_id));
+        }
+    }
+}
+
+void ZmqTransport::Send(int peer_id, PooledBuffer *batch) {
+    if (!own_context_) {
+        // A shared context outlives this node, and an unread batch can sit in a peer's pipe
+        // after our pool is gone, so inproc batches are copied rather than lent.
+        dealers_.at(peer_id).send(zmq::message_t(batch->bytes.data(), batch->bytes.size()),
+                                  zmq::send_flags::none);
+        BufferPool::Release(batch->bytes.data(), batch);
+        return;
+    }
+    dealers_.at(peer_id).send(
+        zmq::message_t(batch->bytes.data(), batch->bytes.size(), &BufferPool::Release, batch),
+        zmq::send_flags::none);
+}
+
+bool ZmqTransport::Poll(std::chrono::milliseconds timeout, const BatchHandler &on_batch) {
+    zmq::pollitem_t items[] = {{static_cast<void *>(router_), 0, ZMQ_POLLIN, 0},
+                               {static_cast<void *>(exit_pair_), 0, ZMQ_POLLIN, 0}};
+    zmq::poll(items, 2, timeout);
+    if (!(items[0].revents & ZMQ_POLLIN)) {
+        return false;
+    }
+
+    // Drain what is already queued; recv() rebuilds the messages in place.
+    while (router_.recv(identity_, zmq::recv_flags::dontwait)) {
+        (void)router_.recv(message_, zmq::recv_flags::none);
+        on_batch(message_.data(), message_.size());
+    }
+    return true;
+}
+
+void ZmqTransport::Interrupt() {
+    zmq::socket_t exit_sender(context_, ZMQ_PAIR);
+    exit_sender.connect(exit_address_);
+    std::string exit_msg = "exit";
+    exit_sender.send(zmq::message_t(exit_msg.data(), exit_msg.size()), zmq::send_flags::none);
+}
@@ -91,6 +91,7 @@ int main(int argc, char *argv[]) {
 
     std::thread receiver(&NetworkNode::ReceiveMessages, &network_node);
     std::thread sender(&NetworkNode::SendMessages, &network_node);
+    network_node.WaitForPeers();
 
     std::vector<std::future<void>> tasks;
     for (int thread = 0; thread < 1000; thread++) {
@@ -106,7 +107,7 @@ int main(int argc, char *argv[]) {
     timer.stop();
     std::cout << "Total time: " << timer.elapsedMicroseconds() << " us" << std::endl;
 
-    std::this_thread::sleep_for(std::chrono::seconds(5));
+    network_node.Drain();
     network_node.Stop();
 
     receiver.join();
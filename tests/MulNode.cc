@@ -63,8 +63,8 @@ void MulTask(int task_id, int operation_id, NetworkNode &network_node) {
 }
 
 int main(int argc, char *argv[]) {
-    if (argc != 2) {
-        std::cerr << "Usage: ./node <node_id>\n";
+    if (argc < 2 || argc > 4) {
+        std::cerr << "Usage: ./node <node_id> [sender_threads] [tcp|ipc|shm]\n";
         return 1;
     }
     int node_id = std::stoi(argv[1]);
@@ -73,11 +73,18 @@ int main(int argc, char *argv[]) {
         return 1;
     }
 
+    NetworkOptions options;
+    if (argc >= 3) {
+        options.sender_threads = std::stoi(argv[2]);
+    }
+    const auto node_addresses = argc == 4 ? LocalNodeAddresses(argv[3]) : default_node_addresses;
+
     int io_threads = 12;
-    NetworkNode network_node(node_id, io_threads);
+    NetworkNode network_node(node_id, io_threads, node_addresses, options);
 
     std::thread receiver(&NetworkNode::ReceiveMessages, &network_node);
     std::thread sender(&NetworkNode::SendMessages, &network_node);
+    network_node.WaitForPeers();
 
     std::vector<std::future<void>> tasks;
     for (int thread = 0; thread < 1000; thread++) {
@@ -92,7 +99,7 @@ int main(int argc, char *argv[]) {
     timer.stop();
     std::cout << "Total time: " << timer.elapsedMicroseconds() << " us" << std::endl;
 
-    std::this_thread::sleep_for(std::chrono::seconds(5));
+    network_node.Drain();
     network_node.Stop();
 
     receiver.join();